@@ -0,0 +1,212 @@
+#ifndef AABB_TREE_H
+#define AABB_TREE_H
+
+#include <learnopengl/frustum_cull.h> //AABBArray, FrustumPlanes
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+//Bounding volume hierarchy over the boxes of an AABBArray, for culling whole groups of objects with one test.
+//build() splits the boxes top-down at the median of their longest axis; nodes are stored depth first, so a node's
+//left child is the next node and the items below any node are one contiguous range. Moving objects don't need a
+//rebuild: refit() recomputes the node bounds bottom up, either for every node or only above the items that moved.
+//Refitting keeps the topology, so rebuild once objects have moved far away from where they were at build time.
+class AABBTree
+{
+public:
+	static const uint32_t LEAF_SIZE = 4;
+
+	struct Node
+	{
+		glm::vec3 min;
+		uint32_t firstItem; //Range in items() of every box below this node
+		glm::vec3 max;
+		uint32_t itemCount;
+		uint32_t right;     //Index of the right child, 0 for leaves (the left child is always the next node)
+		uint32_t parent;
+	};
+
+	//The tree keeps a pointer to bounds: refit() and query() read the current boxes from it
+	void build(const AABBArray& bounds)
+	{
+		boxes = &bounds;
+		const uint32_t count = static_cast<uint32_t>(bounds.size());
+		nodes.clear();
+		nodes.reserve(count > 0 ? 2 * ((count + LEAF_SIZE - 1) / LEAF_SIZE) : 0);
+		items.resize(count);
+		for (uint32_t i = 0; i < count; i++)
+			items[i] = i;
+		leafOf.resize(count);
+		if (count > 0)
+			buildNode(bounds, 0, count, 0);
+	}
+
+	//Recomputes every node from the current bounds
+	void refit()
+	{
+		//Children always come after their parent
+		for (size_t i = nodes.size(); i-- > 0;)
+		{
+			if (nodes[i].right == 0)
+				fitLeaf(*boxes, nodes[i]);
+			else
+				fitInner(static_cast<uint32_t>(i));
+		}
+	}
+
+	//Recomputes only the leaves holding the moved boxes and their ancestors, stopping early where nothing changed
+	void refit(const std::vector<uint32_t>& moved)
+	{
+		for (uint32_t item : moved)
+		{
+			uint32_t index = leafOf[item];
+			fitLeaf(*boxes, nodes[index]);
+			while (index != 0)
+			{
+				index = nodes[index].parent;
+				const glm::vec3 oldMin = nodes[index].min, oldMax = nodes[index].max;
+				fitInner(index);
+				if (nodes[index].min == oldMin && nodes[index].max == oldMax)
+					break;
+			}
+		}
+	}
+
+	//Appends the index of every box touching the frustum to visible, the same boxes cullAABBs() reports. A node that is
+	//completely inside a plane isn't tested against it again further down, and a node inside all planes adds its whole
+	//item range without descending. Returns the number of nodes tested.
+	size_t query(const Frustum& frustum, std::vector<uint32_t>& visible) const
+	{
+		if (nodes.empty())
+			return 0;
+		const FrustumPlanes planes(frustum);
+		size_t tested = 0;
+
+		struct Entry
+		{
+			uint32_t node;
+			uint32_t planeMask; //Planes that still cut through the parent
+		};
+		Entry stack[64];
+		int top = 0;
+		stack[top++] = Entry{ 0, 0x3F };
+		while (top > 0)
+		{
+			const Entry entry = stack[--top];
+			const Node& node = nodes[entry.node];
+			tested++;
+
+			const glm::vec3 center = (node.min + node.max) * 0.5f;
+			const glm::vec3 extents = (node.max - node.min) * 0.5f;
+			uint32_t mask = entry.planeMask;
+			bool outside = false;
+			for (int p = 0; p < 6 && !outside; p++)
+			{
+				if (!(mask & (1u << p)))
+					continue;
+				const float d = center.x * planes.normalX[p] + center.y * planes.normalY[p] + center.z * planes.normalZ[p] - planes.distance[p];
+				const float r = extents.x * planes.absX[p] + extents.y * planes.absY[p] + extents.z * planes.absZ[p];
+				if (d < -r)
+					outside = true;
+				else if (d >= r)
+					mask &= ~(1u << p);
+			}
+			if (outside)
+				continue;
+
+			if (mask == 0)
+			{
+				visible.insert(visible.end(), items.begin() + node.firstItem, items.begin() + node.firstItem + node.itemCount);
+				continue;
+			}
+			if (node.right == 0)
+			{
+				//Leaf still crossing a plane: test its few boxes one by one
+				for (uint32_t i = node.firstItem; i < node.firstItem + node.itemCount; i++)
+				{
+					const uint32_t item = items[i];
+					if (planes.isOnFrustum(boxes->centerX[item], boxes->centerY[item], boxes->centerZ[item],
+						boxes->extentX[item], boxes->extentY[item], boxes->extentZ[item]))
+						visible.push_back(item);
+				}
+				continue;
+			}
+			stack[top++] = Entry{ node.right, mask };
+			stack[top++] = Entry{ entry.node + 1, mask };
+		}
+		return tested;
+	}
+
+	const std::vector<Node>& getNodes() const { return nodes; }
+	const std::vector<uint32_t>& getItems() const { return items; }
+
+private:
+	uint32_t buildNode(const AABBArray& bounds, uint32_t first, uint32_t count, uint32_t parent)
+	{
+		const uint32_t index = static_cast<uint32_t>(nodes.size());
+		nodes.push_back(Node{ glm::vec3(0.f), first, glm::vec3(0.f), count, 0, parent });
+		if (count <= LEAF_SIZE)
+		{
+			for (uint32_t i = first; i < first + count; i++)
+				leafOf[items[i]] = index;
+			fitLeaf(bounds, nodes[index]);
+			return index;
+		}
+
+		//Split at the median center along the axis where the centers spread the most
+		glm::vec3 low(std::numeric_limits<float>::max()), high(-std::numeric_limits<float>::max());
+		for (uint32_t i = first; i < first + count; i++)
+		{
+			const glm::vec3 c = center(bounds, items[i]);
+			low = glm::min(low, c);
+			high = glm::max(high, c);
+		}
+		const glm::vec3 spread = high - low;
+		const int axis = spread.x > spread.y ? (spread.x > spread.z ? 0 : 2) : (spread.y > spread.z ? 1 : 2);
+		const std::vector<float>& key = axis == 0 ? bounds.centerX : axis == 1 ? bounds.centerY : bounds.centerZ;
+		const uint32_t half = count / 2;
+		std::nth_element(items.begin() + first, items.begin() + first + half, items.begin() + first + count,
+			[&key](uint32_t a, uint32_t b) { return key[a] < key[b]; });
+
+		buildNode(bounds, first, half, index);
+		const uint32_t right = buildNode(bounds, first + half, count - half, index);
+		nodes[index].right = right;
+		fitInner(index);
+		return index;
+	}
+
+	static glm::vec3 center(const AABBArray& bounds, uint32_t i)
+	{
+		return { bounds.centerX[i], bounds.centerY[i], bounds.centerZ[i] };
+	}
+
+	void fitLeaf(const AABBArray& bounds, Node& node) const
+	{
+		glm::vec3 low(std::numeric_limits<float>::max()), high(-std::numeric_limits<float>::max());
+		for (uint32_t i = node.firstItem; i < node.firstItem + node.itemCount; i++)
+		{
+			const uint32_t item = items[i];
+			const glm::vec3 extents(bounds.extentX[item], bounds.extentY[item], bounds.extentZ[item]);
+			low = glm::min(low, center(bounds, item) - extents);
+			high = glm::max(high, center(bounds, item) + extents);
+		}
+		node.min = low;
+		node.max = high;
+	}
+
+	void fitInner(uint32_t index)
+	{
+		const Node& left = nodes[index + 1];
+		const Node& right = nodes[nodes[index].right];
+		nodes[index].min = glm::min(left.min, right.min);
+		nodes[index].max = glm::max(left.max, right.max);
+	}
+
+	const AABBArray* boxes = nullptr;
+	std::vector<Node> nodes;
+	std::vector<uint32_t> items;  //Box indices in tree order
+	std::vector<uint32_t> leafOf; //Leaf node of each box
+};
+#endif
@@ -17,6 +17,18 @@ struct AssimpNodeData
 	std::vector<AssimpNodeData> children;
 };
 
+/* AssimpNodeData compiled for playback: nodes are stored depth first, so a parent always comes before its
+   children, and the names are already resolved to indices */
+struct AnimationNode
+{
+	glm::mat4 transformation; // local transform when no channel animates the node
+	BonePose pose;            // the same, split up for blending
+	glm::mat4 offset;         // model space to bone space, if boneID >= 0
+	int parent;               // -1 for the root
+	int channel;              // index into GetBones(), -1 if the node isn't animated
+	int boneID;               // index in the final bone matrices, -1 if no vertex is bound to the node
+};
+
 class Animation
 {
 public:
@@ -34,6 +46,16 @@ public:
 		globalTransformation = globalTransformation.Inverse();
 		ReadHierarchyData(m_RootNode, scene->mRootNode);
 		ReadMissingBones(animation, *model);
+		CompileHierarchy();
+	}
+
+	/* an animation that doesn't come from a file, e.g. generated or converted */
+	Animation(float duration, int ticksPerSecond, const AssimpNodeData& root, std::vector<Bone> bones,
+		const std::map<std::string, BoneInfo>& boneInfoMap)
+		: m_Duration(duration), m_TicksPerSecond(ticksPerSecond), m_Bones(std::move(bones)),
+		m_RootNode(root), m_BoneInfoMap(boneInfoMap)
+	{
+		CompileHierarchy();
 	}
 
 	~Animation()
@@ -53,13 +75,107 @@ public:
 	}
 
 	
-	inline float GetTicksPerSecond() { return m_TicksPerSecond; }
-	inline float GetDuration() { return m_Duration;}
+	/* resamples every bone track to keysPerSecond evenly spaced keys (see Bone::Resample) */
+	void Resample(float keysPerSecond)
+	{
+		const float ticksPerSecond = m_TicksPerSecond > 0 ? (float)m_TicksPerSecond : 1.0f;
+		for (Bone& bone : m_Bones)
+			bone.Resample(keysPerSecond / ticksPerSecond, m_Duration);
+	}
+
+	/* compresses the keys of every bone (see Bone::Compress), meant to run once after import */
+	void Compress(const BoneCompression& settings = BoneCompression())
+	{
+		for (Bone& bone : m_Bones)
+			bone.Compress(settings);
+	}
+
+	/* bytes taken by the keys of all bones */
+	size_t GetKeyMemory() const
+	{
+		size_t bytes = 0;
+		for (const Bone& bone : m_Bones)
+			bytes += bone.GetKeyMemory();
+		return bytes;
+	}
+
+	inline float GetTicksPerSecond() const { return m_TicksPerSecond; }
+	inline float GetDuration() const { return m_Duration;}
 	inline const AssimpNodeData& GetRootNode() { return m_RootNode; }
 	inline const std::map<std::string,BoneInfo>& GetBoneIDMap() 
 	{ 
 		return m_BoneInfoMap;
 	}
+	inline const std::vector<AnimationNode>& GetNodes() const { return m_Nodes; }
+	inline const std::vector<Bone>& GetBones() const { return m_Bones; }
+	/* number of final bone matrices the hierarchy writes (highest bone id + 1) */
+	inline int GetPaletteSize() const { return m_PaletteSize; }
+
+	/* Poses the compiled hierarchy at time (in ticks) in one pass; parents come first, so their global transform
+	   is always ready. cursors has one entry per bone channel, globals one per node; the final bone matrices
+	   with an id below paletteSize are written to palette. Only reads the animation, so any number of threads
+	   can evaluate it at once as long as each has its own cursors and buffers */
+	void Evaluate(float time, BoneCursor* cursors, glm::mat4* globals, glm::mat4* palette, int paletteSize) const
+	{
+		for (size_t i = 0; i < m_Nodes.size(); i++)
+		{
+			const AnimationNode& node = m_Nodes[i];
+			const glm::mat4 nodeTransform = node.channel >= 0
+				? m_Bones[node.channel].Sample(time, cursors[node.channel])
+				: node.transformation;
+			if (node.parent >= 0)
+				MultiplyAffine(globals[node.parent], nodeTransform, globals[i]);
+			else
+				globals[i] = nodeTransform;
+			if (node.boneID >= 0 && node.boneID < paletteSize)
+				MultiplyAffine(globals[i], node.offset, palette[node.boneID]);
+		}
+	}
+
+	/* Local pose of every node at time, the input of blending (see Animator). Clips blended together have to
+	   share the node hierarchy, i.e. come from the same rig; nodes without a channel get their static pose */
+	void SamplePose(float time, BoneCursor* cursors, BonePose* pose) const
+	{
+		for (size_t i = 0; i < m_Nodes.size(); i++)
+		{
+			const AnimationNode& node = m_Nodes[i];
+			pose[i] = node.channel >= 0 ? m_Bones[node.channel].SamplePose(time, cursors[node.channel]) : node.pose;
+		}
+	}
+
+	/* Evaluate for a pose from SamplePose, blended or not */
+	void EvaluatePose(const BonePose* pose, glm::mat4* globals, glm::mat4* palette, int paletteSize) const
+	{
+		for (size_t i = 0; i < m_Nodes.size(); i++)
+		{
+			const AnimationNode& node = m_Nodes[i];
+			if (node.parent >= 0)
+				MultiplyAffine(globals[node.parent], pose[i].ToMatrix(), globals[i]);
+			else
+				globals[i] = pose[i].ToMatrix();
+			if (node.boneID >= 0 && node.boneID < paletteSize)
+				MultiplyAffine(globals[i], node.offset, palette[node.boneID]);
+		}
+	}
+
+	/* out = a * b for transforms whose last row is (0, 0, 0, 1), which node, bone and offset matrices all are.
+	   Written out on plain floats: in big translation units the compiler stops inlining glm's vector operators,
+	   and a mat4 product of out-of-line calls costs several times as much */
+	static void MultiplyAffine(const glm::mat4& a, const glm::mat4& b, glm::mat4& out)
+	{
+		for (int c = 0; c < 4; c++)
+		{
+			float column[3];
+			for (int r = 0; r < 3; r++)
+				column[r] = a[0][r] * b[c][0] + a[1][r] * b[c][1] + a[2][r] * b[c][2];
+			if (c == 3)
+				for (int r = 0; r < 3; r++)
+					column[r] += a[3][r];
+			for (int r = 0; r < 3; r++)
+				out[c][r] = column[r];
+			out[c][3] = c == 3 ? 1.0f : 0.0f;
+		}
+	}
 
 private:
 	void ReadMissingBones(const aiAnimation* animation, Model& model)
@@ -102,10 +218,44 @@ private:
 			dest.children.push_back(newData);
 		}
 	}
+	void CompileHierarchy()
+	{
+		std::map<std::string, int> channels;
+		for (int i = 0; i < (int)m_Bones.size(); i++)
+			channels.emplace(m_Bones[i].GetBoneName(), i); // the first channel wins, like FindBone
+
+		m_Nodes.clear();
+		m_PaletteSize = 0;
+		CompileNode(m_RootNode, -1, channels);
+	}
+
+	void CompileNode(const AssimpNodeData& src, int parent, const std::map<std::string, int>& channels)
+	{
+		AnimationNode node;
+		node.transformation = src.transformation;
+		node.pose = BonePose::FromMatrix(src.transformation);
+		node.offset = glm::mat4(1.0f);
+		node.parent = parent;
+		auto channel = channels.find(src.name);
+		node.channel = channel != channels.end() ? channel->second : -1;
+		auto boneInfo = m_BoneInfoMap.find(src.name);
+		node.boneID = boneInfo != m_BoneInfoMap.end() ? boneInfo->second.id : -1;
+		if (boneInfo != m_BoneInfoMap.end())
+			node.offset = boneInfo->second.offset;
+		m_PaletteSize = std::max(m_PaletteSize, node.boneID + 1);
+
+		const int index = (int)m_Nodes.size();
+		m_Nodes.push_back(node);
+		for (int i = 0; i < src.childrenCount; i++)
+			CompileNode(src.children[i], index, channels);
+	}
+
 	float m_Duration;
 	int m_TicksPerSecond;
 	std::vector<Bone> m_Bones;
 	AssimpNodeData m_RootNode;
 	std::map<std::string, BoneInfo> m_BoneInfoMap;
+	std::vector<AnimationNode> m_Nodes;
+	int m_PaletteSize = 0;
 };
 
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <cmath>
+#include <vector>
+#include <learnopengl/animation.h>
+#include <learnopengl/bone.h>
+#include <learnopengl/thread_pool.h>
+
+/* Plays many animated characters at once, the crowd version of Animator. Every instance has its own clip time,
+   speed and keyframe cursors, while the clips themselves are shared and only read. Update() poses the instances in
+   parallel on a ThreadPool and each one writes its final bone matrices into its own slice of one contiguous
+   buffer, GetBonesPerInstance() matrices apart, so all palettes can be uploaded to the GPU with a single call. */
+class AnimationSystem
+{
+public:
+	AnimationSystem(int bonesPerInstance = 100, ThreadPool* pool = nullptr)
+		: m_BonesPerInstance(bonesPerInstance), m_Pool(pool ? pool : &ThreadPool::shared())
+	{
+	}
+
+	/* returns the index of the new instance; startTime is in seconds, speed scales the clip's tick rate */
+	int AddInstance(Animation* animation, float startTime = 0.0f, float speed = 1.0f)
+	{
+		Instance instance;
+		instance.speed = speed;
+		m_Instances.push_back(instance);
+		m_Palettes.resize(m_Instances.size() * m_BonesPerInstance, glm::mat4(1.0f));
+
+		const int index = (int)m_Instances.size() - 1;
+		PlayAnimation(index, animation);
+		if (animation)
+			m_Instances[index].time = std::fmod(animation->GetTicksPerSecond() * startTime, animation->GetDuration());
+		return index;
+	}
+
+	void PlayAnimation(int instance, Animation* animation)
+	{
+		Instance& target = m_Instances[instance];
+		target.animation = animation;
+		target.time = 0.0f;
+		target.cursors.assign(animation ? animation->GetBones().size() : 0, BoneCursor());
+	}
+
+	/* advances every instance by dt seconds and poses it; returns once every palette is written */
+	void Update(float dt)
+	{
+		m_Pool->parallelFor(m_Instances.size(), [this, dt](size_t i) { UpdateInstance(i, dt); });
+	}
+
+	inline const glm::mat4* GetFinalBoneMatrices(int instance) const { return &m_Palettes[(size_t)instance * m_BonesPerInstance]; }
+	/* the palettes of all instances, in instance order */
+	inline const std::vector<glm::mat4>& GetPalettes() const { return m_Palettes; }
+	inline int GetBonesPerInstance() const { return m_BonesPerInstance; }
+	inline int GetInstanceCount() const { return (int)m_Instances.size(); }
+
+private:
+	struct Instance
+	{
+		Animation* animation = nullptr;
+		float time = 0.0f;
+		float speed = 1.0f;
+		std::vector<BoneCursor> cursors; // per animation channel
+	};
+
+	void UpdateInstance(size_t index, float dt)
+	{
+		Instance& instance = m_Instances[index];
+		const Animation* animation = instance.animation;
+		if (!animation)
+			return;
+		instance.time += animation->GetTicksPerSecond() * dt * instance.speed;
+		instance.time = std::fmod(instance.time, animation->GetDuration());
+
+		// node transforms only live during the evaluation, one scratch buffer per thread is enough
+		static thread_local std::vector<glm::mat4> globals;
+		globals.resize(animation->GetNodes().size());
+		animation->Evaluate(instance.time, instance.cursors.data(), globals.data(),
+			&m_Palettes[index * m_BonesPerInstance], m_BonesPerInstance);
+	}
+
+	int m_BonesPerInstance;
+	ThreadPool* m_Pool;
+	std::vector<Instance> m_Instances;
+	std::vector<glm::mat4> m_Palettes;
+};
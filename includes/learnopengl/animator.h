@@ -1,6 +1,8 @@
 #pragma once
 
 #include <glm/glm.hpp>
+#include <algorithm>
+#include <cassert>
 #include <map>
 #include <vector>
 #include <assimp/scene.h>
@@ -15,11 +17,7 @@ public:
 	{
 		m_CurrentTime = 0.0;
 		m_CurrentAnimation = animation;
-
-		m_FinalBoneMatrices.reserve(100);
-
-		for (int i = 0; i < 100; i++)
-			m_FinalBoneMatrices.push_back(glm::mat4(1.0f));
+		ResizePalette();
 	}
 
 	void UpdateAnimation(float dt)
@@ -27,18 +25,123 @@ public:
 		m_DeltaTime = dt;
 		if (m_CurrentAnimation)
 		{
-			m_CurrentTime += m_CurrentAnimation->GetTicksPerSecond() * dt;
-			m_CurrentTime = fmod(m_CurrentTime, m_CurrentAnimation->GetDuration());
-			CalculateBoneTransform(&m_CurrentAnimation->GetRootNode(), glm::mat4(1.0f));
+			m_CurrentTime = Advance(m_CurrentAnimation, m_CurrentTime, dt);
+			if (m_PreviousAnimation)
+			{
+				m_PreviousTime = Advance(m_PreviousAnimation, m_PreviousTime, dt);
+				m_FadeTime += dt;
+				if (m_FadeTime >= m_FadeDuration)
+					m_PreviousAnimation = nullptr;
+			}
+			bool layered = false;
+			for (Layer& layer : m_Layers)
+			{
+				layer.time = Advance(layer.animation, layer.time, dt);
+				layered = layered || layer.weight > 0.0f;
+			}
+
+			if (m_PreviousAnimation || layered)
+				EvaluateBlend();
+			else
+				EvaluateHierarchy();
 		}
 	}
 
+	/* switches to pAnimation right away, cancelling a crossfade */
 	void PlayAnimation(Animation* pAnimation)
 	{
 		m_CurrentAnimation = pAnimation;
 		m_CurrentTime = 0.0f;
+		m_Cursors.clear();
+		m_PreviousAnimation = nullptr;
+		ResizePalette();
+	}
+
+	/* Starts pAnimation from its beginning and blends over to it from the current clip within seconds. The
+	   clip being faded out keeps playing; starting another crossfade drops it */
+	void CrossFade(Animation* pAnimation, float seconds)
+	{
+		if (!m_CurrentAnimation || seconds <= 0.0f)
+		{
+			PlayAnimation(pAnimation);
+			return;
+		}
+		assert(pAnimation->GetNodes().size() == m_CurrentAnimation->GetNodes().size());
+		m_PreviousAnimation = m_CurrentAnimation;
+		m_PreviousTime = m_CurrentTime;
+		m_PreviousCursors.swap(m_Cursors);
+		m_PreviousCursors.resize(m_PreviousAnimation->GetBones().size());
+		m_CurrentAnimation = pAnimation;
+		m_CurrentTime = 0.0f;
+		m_Cursors.assign(pAnimation->GetBones().size(), BoneCursor());
+		m_FadeTime = 0.0f;
+		m_FadeDuration = seconds;
+		ReservePoses(pAnimation->GetNodes().size());
+	}
+
+	/* Layers an additive clip on top of whatever plays: weight times its difference to its own first frame,
+	   e.g. breathing or an aim offset. Returns the index for SetLayerWeight */
+	int AddLayer(Animation* pAnimation, float weight = 1.0f)
+	{
+		assert(!m_CurrentAnimation || pAnimation->GetNodes().size() == m_CurrentAnimation->GetNodes().size());
+		Layer layer;
+		layer.animation = pAnimation;
+		layer.weight = weight;
+		layer.cursors.assign(pAnimation->GetBones().size(), BoneCursor());
+		layer.reference.resize(pAnimation->GetNodes().size());
+		std::vector<BoneCursor> cursors(pAnimation->GetBones().size());
+		pAnimation->SamplePose(0.0f, cursors.data(), layer.reference.data());
+		m_Layers.push_back(std::move(layer));
+		ReservePoses(pAnimation->GetNodes().size());
+		return (int)m_Layers.size() - 1;
+	}
+
+	void SetLayerWeight(int layer, float weight) { m_Layers[layer].weight = weight; }
+	bool IsCrossFading() const { return m_PreviousAnimation != nullptr; }
+
+	/* One pass over the compiled hierarchy (see Animation::Evaluate). No names, no maps and, after the first
+	   frame, no allocations */
+	void EvaluateHierarchy()
+	{
+		m_Cursors.resize(m_CurrentAnimation->GetBones().size());
+		m_GlobalTransforms.resize(m_CurrentAnimation->GetNodes().size());
+		m_CurrentAnimation->Evaluate(m_CurrentTime, m_Cursors.data(), m_GlobalTransforms.data(),
+			m_FinalBoneMatrices.data(), (int)m_FinalBoneMatrices.size());
+	}
+
+	/* The same in local pose space when clips are mixed: sample the current clip, blend in the clip fading out,
+	   add the layers and evaluate the result. Every buffer is sized when a clip or layer is added */
+	void EvaluateBlend()
+	{
+		const size_t nodeCount = m_CurrentAnimation->GetNodes().size();
+		m_Cursors.resize(m_CurrentAnimation->GetBones().size());
+		ReservePoses(nodeCount);
+		BonePose* pose = m_Pose.data();
+		BonePose* blend = m_BlendPose.data();
+		m_CurrentAnimation->SamplePose(m_CurrentTime, m_Cursors.data(), pose);
+
+		if (m_PreviousAnimation)
+		{
+			m_PreviousAnimation->SamplePose(m_PreviousTime, m_PreviousCursors.data(), blend);
+			const float weight = m_FadeTime / m_FadeDuration;
+			for (size_t i = 0; i < nodeCount; i++)
+				pose[i] = BlendPoses(blend[i], pose[i], weight);
+		}
+		for (Layer& layer : m_Layers)
+		{
+			if (layer.weight <= 0.0f)
+				continue;
+			layer.animation->SamplePose(layer.time, layer.cursors.data(), blend);
+			for (size_t i = 0; i < nodeCount; i++)
+				pose[i] = AddPose(pose[i], blend[i], layer.reference[i], layer.weight);
+		}
+
+		m_GlobalTransforms.resize(nodeCount);
+		m_CurrentAnimation->EvaluatePose(pose, m_GlobalTransforms.data(),
+			m_FinalBoneMatrices.data(), (int)m_FinalBoneMatrices.size());
 	}
 
+	/* the recursive evaluation, looking every node up by name; UpdateAnimation uses EvaluateHierarchy */
 	void CalculateBoneTransform(const AssimpNodeData* node, glm::mat4 parentTransform)
 	{
 		std::string nodeName = node->name;
@@ -66,15 +169,62 @@ public:
 			CalculateBoneTransform(&node->children[i], globalTransformation);
 	}
 
-	std::vector<glm::mat4> GetFinalBoneMatrices()
+	/* valid until the next update; one matrix per bone id of the rig, the buffer only changes with PlayAnimation */
+	const std::vector<glm::mat4>& GetFinalBoneMatrices() const
 	{
 		return m_FinalBoneMatrices;
 	}
 
 private:
+	struct Layer
+	{
+		Animation* animation;
+		float time = 0.0f;
+		float weight = 1.0f;
+		std::vector<BoneCursor> cursors;
+		std::vector<BonePose> reference; // first frame, what the layer adds is the difference to it
+	};
+
+	static float Advance(Animation* animation, float time, float dt)
+	{
+		return fmod(time + animation->GetTicksPerSecond() * dt, animation->GetDuration());
+	}
+
+	/* one matrix per bone id of the rig, also for bones the clip doesn't reach (they stay identity), so rigs with
+	   any number of bones fit */
+	void ResizePalette()
+	{
+		if (!m_CurrentAnimation)
+			return;
+		int size = m_CurrentAnimation->GetPaletteSize();
+		for (const auto& bone : m_CurrentAnimation->GetBoneIDMap())
+			size = std::max(size, bone.second.id + 1);
+		m_FinalBoneMatrices.resize(size, glm::mat4(1.0f));
+	}
+
+	void ReservePoses(size_t nodeCount)
+	{
+		if (m_Pose.size() < nodeCount)
+		{
+			m_Pose.resize(nodeCount);
+			m_BlendPose.resize(nodeCount);
+		}
+	}
+
 	std::vector<glm::mat4> m_FinalBoneMatrices;
+	std::vector<glm::mat4> m_GlobalTransforms; // per compiled node
+	std::vector<BoneCursor> m_Cursors;         // per animation channel
 	Animation* m_CurrentAnimation;
 	float m_CurrentTime;
 	float m_DeltaTime;
 
+	Animation* m_PreviousAnimation = nullptr; // fading out
+	float m_PreviousTime = 0.0f;
+	std::vector<BoneCursor> m_PreviousCursors;
+	float m_FadeTime = 0.0f;
+	float m_FadeDuration = 0.0f;
+	std::vector<Layer> m_Layers;
+	std::vector<BonePose> m_Pose;      // per node, blended
+	std::vector<BonePose> m_BlendPose; // per node, the clip blended in
+
 };
@@ -3,6 +3,9 @@
 /* Container for bone data */
 
 #include <vector>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
 #include <assimp/scene.h>
 #include <list>
 #include <glm/glm.hpp>
@@ -28,6 +31,94 @@ struct KeyScale
 	float timeStamp;
 };
 
+/* Key index each track of a bone was last sampled at. A Bone can be shared by many animators, so every
+   animator keeps its own cursors; playing forward then finds the next key without searching */
+struct BoneCursor
+{
+	int position = 0;
+	int rotation = 0;
+	int scale = 0;
+};
+
+/* Local transform split into translation, rotation and scale, the space clips are blended in */
+struct BonePose
+{
+	glm::vec3 position = glm::vec3(0.0f);
+	glm::quat rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+	glm::vec3 scale = glm::vec3(1.0f);
+
+	/* translation * rotation * scale, without the two matrix products */
+	glm::mat4 ToMatrix() const
+	{
+		glm::mat4 transform = glm::toMat4(rotation);
+		transform[0] *= scale.x;
+		transform[1] *= scale.y;
+		transform[2] *= scale.z;
+		transform[3] = glm::vec4(position, 1.0f);
+		return transform;
+	}
+
+	/* the inverse of ToMatrix for transforms without shear or mirroring, e.g. the static nodes of a rig */
+	static BonePose FromMatrix(const glm::mat4& transform)
+	{
+		BonePose pose;
+		pose.position = glm::vec3(transform[3]);
+		pose.scale = glm::vec3(glm::length(glm::vec3(transform[0])), glm::length(glm::vec3(transform[1])), glm::length(glm::vec3(transform[2])));
+		pose.rotation = glm::normalize(glm::quat_cast(glm::mat3(glm::vec3(transform[0]) / pose.scale.x,
+			glm::vec3(transform[1]) / pose.scale.y, glm::vec3(transform[2]) / pose.scale.z)));
+		return pose;
+	}
+};
+
+/* weight 0 gives a, weight 1 gives b. Rotations are blended with a normalized lerp along the shorter arc,
+   close enough to slerp for blend weights and a lot cheaper */
+inline BonePose BlendPoses(const BonePose& a, const BonePose& b, float weight)
+{
+	BonePose pose;
+	pose.position = glm::mix(a.position, b.position, weight);
+	pose.scale = glm::mix(a.scale, b.scale, weight);
+	const float sign = glm::dot(a.rotation, b.rotation) < 0.0f ? -1.0f : 1.0f;
+	pose.rotation = glm::normalize(a.rotation * (1.0f - weight) + b.rotation * (sign * weight));
+	return pose;
+}
+
+/* Adds weight times the difference between additive and reference (usually the first frame of the additive
+   clip) on top of base: translations add, scales multiply and the rotation difference is applied locally */
+inline BonePose AddPose(const BonePose& base, const BonePose& additive, const BonePose& reference, float weight)
+{
+	BonePose pose;
+	pose.position = base.position + (additive.position - reference.position) * weight;
+	pose.scale = base.scale * glm::mix(glm::vec3(1.0f), additive.scale / reference.scale, weight);
+	glm::quat delta = glm::conjugate(reference.rotation) * additive.rotation; // the inverse of a unit quaternion
+	if (delta.w < 0.0f)
+		delta = -delta; // the shorter way round
+	const glm::quat partial(1.0f - weight + delta.w * weight, delta.x * weight, delta.y * weight, delta.z * weight);
+	pose.rotation = glm::normalize(base.rotation * glm::normalize(partial));
+	return pose;
+}
+
+/* Tolerances for Bone::Compress: no original key ends up further than this from the compressed track */
+struct BoneCompression
+{
+	float positionTolerance = 0.001f; // per component, in the units of the model
+	float rotationTolerance = 0.001f; // angle in radians
+	float scaleTolerance = 0.001f;    // per component
+};
+
+/* A key track after compression: the times of the keys that were kept and three 16-bit values per key.
+   Positions and scales are quantized within the bounds of the track, min + value * step; rotations are stored
+   smallest three, see Bone::EncodeRotation */
+struct CompressedTrack
+{
+	std::vector<float> times;
+	std::vector<uint16_t> values;
+	glm::vec3 min = glm::vec3(0.0f);
+	glm::vec3 step = glm::vec3(0.0f);
+
+	size_t GetKeyCount() const { return times.size(); }
+	size_t GetMemoryUsage() const { return times.size() * sizeof(float) + values.size() * sizeof(uint16_t) + 2 * sizeof(glm::vec3); }
+};
+
 class Bone
 {
 public:
@@ -71,109 +162,417 @@ public:
 			m_Scales.push_back(data);
 		}
 	}
+
+	/* keys that don't come from assimp, e.g. generated or converted ones; every track needs at least one key */
+	Bone(const std::string& name, int ID, std::vector<KeyPosition> positions,
+		std::vector<KeyRotation> rotations, std::vector<KeyScale> scales)
+		:
+		m_Positions(std::move(positions)),
+		m_Rotations(std::move(rotations)),
+		m_Scales(std::move(scales)),
+		m_LocalTransform(1.0f),
+		m_Name(name),
+		m_ID(ID)
+	{
+		m_NumPositions = (int)m_Positions.size();
+		m_NumRotations = (int)m_Rotations.size();
+		m_NumScalings = (int)m_Scales.size();
+	}
 	
 	void Update(float animationTime)
 	{
-		glm::mat4 translation = InterpolatePosition(animationTime);
-		glm::mat4 rotation = InterpolateRotation(animationTime);
-		glm::mat4 scale = InterpolateScaling(animationTime);
-		m_LocalTransform = translation * rotation * scale;
+		m_LocalTransform = Sample(animationTime, m_Cursor);
 	}
+
+	/* local transform at animationTime, searching the keys from cursor and moving it along */
+	glm::mat4 Sample(float animationTime, BoneCursor& cursor) const
+	{
+		return SamplePose(animationTime, cursor).ToMatrix();
+	}
+
+	/* the same as Sample, before the translation, rotation and scale are combined into a matrix */
+	BonePose SamplePose(float animationTime, BoneCursor& cursor) const
+	{
+		BonePose pose;
+		if (m_Compressed)
+		{
+			pose.rotation = InterpolatedRotation(m_CompressedRotations, animationTime, cursor.rotation);
+			pose.scale = InterpolatedVector(m_CompressedScales, animationTime, cursor.scale);
+			pose.position = InterpolatedVector(m_CompressedPositions, animationTime, cursor.position);
+		}
+		else
+		{
+			pose.rotation = InterpolatedRotation(animationTime, cursor.rotation);
+			pose.scale = InterpolatedScale(animationTime, cursor.scale);
+			pose.position = InterpolatedPosition(animationTime, cursor.position);
+		}
+		return pose;
+	}
+
 	glm::mat4 GetLocalTransform() { return m_LocalTransform; }
 	std::string GetBoneName() const { return m_Name; }
 	int GetBoneID() { return m_ID; }
 	
+	/* the keys as imported; empty once the bone is compressed */
+	const std::vector<KeyPosition>& GetPositionKeys() const { return m_Positions; }
+	const std::vector<KeyRotation>& GetRotationKeys() const { return m_Rotations; }
+	const std::vector<KeyScale>& GetScaleKeys() const { return m_Scales; }
 
+	/* index of the key pair around animationTime; hint is where the previous lookup ended */
+	int GetPositionIndex(float animationTime, int hint = -1) const { return FindKeyIndex(m_Positions, animationTime, hint); }
+	int GetRotationIndex(float animationTime, int hint = -1) const { return FindKeyIndex(m_Rotations, animationTime, hint); }
+	int GetScaleIndex(float animationTime, int hint = -1) const { return FindKeyIndex(m_Scales, animationTime, hint); }
 
-	int GetPositionIndex(float animationTime)
+	/* Replaces the keys with keys at a fixed rate (in keys per tick), so finding the key pair is a single
+	   multiplication. In between the original keys the track is only approximated: pick a rate at least
+	   as high as the one the clip was recorded with */
+	void Resample(float keysPerTick, float duration)
 	{
-		for (int index = 0; index < m_NumPositions - 1; ++index)
+		if (m_Compressed)
+			return; // the reduced tracks are no longer evenly spaced, and resampling would add the keys back
+		const int count = std::max((int)std::ceil(duration * keysPerTick), 1) + 1;
+		BoneCursor cursor;
+		if (m_NumPositions > 1)
 		{
-			if (animationTime < m_Positions[index + 1].timeStamp)
-				return index;
+			std::vector<KeyPosition> keys(count);
+			for (int i = 0; i < count; ++i)
+			{
+				keys[i].timeStamp = i / keysPerTick;
+				keys[i].position = InterpolatedPosition(keys[i].timeStamp, cursor.position);
+			}
+			m_Positions.swap(keys);
+			m_NumPositions = count;
 		}
-		assert(0);
+		if (m_NumRotations > 1)
+		{
+			std::vector<KeyRotation> keys(count);
+			for (int i = 0; i < count; ++i)
+			{
+				keys[i].timeStamp = i / keysPerTick;
+				keys[i].orientation = InterpolatedRotation(keys[i].timeStamp, cursor.rotation);
+			}
+			m_Rotations.swap(keys);
+			m_NumRotations = count;
+		}
+		if (m_NumScalings > 1)
+		{
+			std::vector<KeyScale> keys(count);
+			for (int i = 0; i < count; ++i)
+			{
+				keys[i].timeStamp = i / keysPerTick;
+				keys[i].scale = InterpolatedScale(keys[i].timeStamp, cursor.scale);
+			}
+			m_Scales.swap(keys);
+			m_NumScalings = count;
+		}
+		m_KeysPerTick = keysPerTick;
 	}
 
-	int GetRotationIndex(float animationTime)
+	bool IsResampled() const { return m_KeysPerTick > 0.0f; }
+
+	/* Import-time compression. Drops every key the interpolation of its neighbours reproduces within the
+	   tolerance, collapses constant tracks to a single key and quantizes what is left to 16 bits per component.
+	   The kept keys are chosen on the quantized values, so the tolerance covers the quantization error too */
+	void Compress(const BoneCompression& settings = BoneCompression())
 	{
-		for (int index = 0; index < m_NumRotations - 1; ++index)
-		{
-			if (animationTime < m_Rotations[index + 1].timeStamp)
-				return index;
-		}
-		assert(0);
+		if (m_Compressed)
+			return;
+		m_CompressedPositions = CompressVectors(m_Positions, settings.positionTolerance,
+			[](const KeyPosition& key) { return key.position; });
+		m_CompressedScales = CompressVectors(m_Scales, settings.scaleTolerance,
+			[](const KeyScale& key) { return key.scale; });
+		m_CompressedRotations = CompressRotations(m_Rotations, settings.rotationTolerance);
+
+		std::vector<KeyPosition>().swap(m_Positions);
+		std::vector<KeyRotation>().swap(m_Rotations);
+		std::vector<KeyScale>().swap(m_Scales);
+		m_KeysPerTick = 0.0f;
+		m_Compressed = true;
 	}
 
-	int GetScaleIndex(float animationTime)
+	bool IsCompressed() const { return m_Compressed; }
+	const CompressedTrack& GetCompressedPositions() const { return m_CompressedPositions; }
+	const CompressedTrack& GetCompressedRotations() const { return m_CompressedRotations; }
+	const CompressedTrack& GetCompressedScales() const { return m_CompressedScales; }
+
+	/* bytes taken by the keys of all three tracks */
+	size_t GetKeyMemory() const
 	{
-		for (int index = 0; index < m_NumScalings - 1; ++index)
+		if (m_Compressed)
+			return m_CompressedPositions.GetMemoryUsage() + m_CompressedRotations.GetMemoryUsage() + m_CompressedScales.GetMemoryUsage();
+		return m_Positions.size() * sizeof(KeyPosition) + m_Rotations.size() * sizeof(KeyRotation) + m_Scales.size() * sizeof(KeyScale);
+	}
+
+	/* Smallest three: the largest component of a unit quaternion follows from the other three, which all lie in
+	   [-1/sqrt(2), 1/sqrt(2)]. Those three get 15 bits each; the top bits of the first two hold which component
+	   was dropped. q and -q are the same rotation, so the dropped component is made positive */
+	static void EncodeRotation(glm::quat q, uint16_t* out)
+	{
+		q = glm::normalize(q);
+		int largest = 0;
+		for (int i = 1; i < 4; i++)
+			if (std::abs(q[i]) > std::abs(q[largest]))
+				largest = i;
+		if (q[largest] < 0.0f)
+			q = -q;
+		for (int i = 0, j = 0; i < 4; i++)
+			if (i != largest)
+				out[j++] = (uint16_t)std::lround((glm::clamp(q[i] * SQRT2, -1.0f, 1.0f) * 0.5f + 0.5f) * 32767.0f);
+		out[0] |= (uint16_t)((largest & 1) << 15);
+		out[1] |= (uint16_t)((largest >> 1) << 15);
+	}
+
+	static glm::quat DecodeRotation(const uint16_t* in)
+	{
+		const float scale = 2.0f / (32767.0f * SQRT2), bias = -1.0f / SQRT2;
+		const float a = (in[0] & 0x7FFF) * scale + bias;
+		const float b = (in[1] & 0x7FFF) * scale + bias;
+		const float c = in[2] * scale + bias;
+		const float largest = std::sqrt(std::max(1.0f - a * a - b * b - c * c, 0.0f));
+		switch ((in[0] >> 15) | ((in[1] >> 15) << 1)) // glm::quat(w, x, y, z)
 		{
-			if (animationTime < m_Scales[index + 1].timeStamp)
-				return index;
+		case 0: return glm::quat(c, largest, a, b);
+		case 1: return glm::quat(c, a, largest, b);
+		case 2: return glm::quat(c, a, b, largest);
+		default: return glm::quat(largest, a, b, c);
 		}
-		assert(0);
+	}
+
+	static glm::vec3 DecodeVector(const CompressedTrack& track, size_t key)
+	{
+		const uint16_t* value = &track.values[key * 3];
+		return track.min + glm::vec3(value[0], value[1], value[2]) * track.step;
+	}
+
+	/* rotation angle from a to b. |a - b| = 2 sin(angle / 4) for unit quaternions, which unlike acos of the dot
+	   product stays accurate for tiny angles */
+	static float AngleBetween(glm::quat a, glm::quat b)
+	{
+		a = glm::normalize(a);
+		b = glm::normalize(b);
+		const float chord = std::min(glm::length(glm::vec4(a.x - b.x, a.y - b.y, a.z - b.z, a.w - b.w)),
+			glm::length(glm::vec4(a.x + b.x, a.y + b.y, a.z + b.z, a.w + b.w)));
+		return 4.0f * std::asin(std::min(chord * 0.5f, 1.0f));
 	}
 
 
 private:
 
-	float GetScaleFactor(float lastTimeStamp, float nextTimeStamp, float animationTime)
+	/* FindKeyIndex works on key structs and on the time arrays of compressed tracks */
+	template<typename Key>
+	static float KeyTime(const Key& key) { return key.timeStamp; }
+	static float KeyTime(float time) { return time; }
+
+	template<typename Key>
+	int FindKeyIndex(const std::vector<Key>& keys, float animationTime, int hint) const
+	{
+		const int last = (int)keys.size() - 2; // the last key pair starts here
+		if (last <= 0)
+			return 0;
+		if (m_KeysPerTick > 0.0f)
+			return std::min(std::max((int)(animationTime * m_KeysPerTick), 0), last);
+
+		// playing forward: still in the same key pair, or in the next one
+		if (hint >= 0 && hint <= last && KeyTime(keys[hint]) <= animationTime)
+		{
+			if (animationTime < KeyTime(keys[hint + 1]))
+				return hint;
+			if (hint < last && animationTime < KeyTime(keys[hint + 2]))
+				return hint + 1;
+		}
+
+		// seeking (or looping): binary search for the first key after animationTime
+		auto next = std::upper_bound(keys.begin() + 1, keys.end(), animationTime,
+			[](float time, const Key& key) { return time < KeyTime(key); });
+		return std::min((int)(next - keys.begin()) - 1, last);
+	}
+
+	static float GetScaleFactor(float lastTimeStamp, float nextTimeStamp, float animationTime)
 	{
 		float scaleFactor = 0.0f;
 		float midWayLength = animationTime - lastTimeStamp;
 		float framesDiff = nextTimeStamp - lastTimeStamp;
 		scaleFactor = midWayLength / framesDiff;
-		return scaleFactor;
+		// before the first or after the last key the track holds its end value
+		return glm::clamp(scaleFactor, 0.0f, 1.0f);
 	}
 
-	glm::mat4 InterpolatePosition(float animationTime)
+	glm::vec3 InterpolatedPosition(float animationTime, int& cursor) const
 	{
 		if (1 == m_NumPositions)
-			return glm::translate(glm::mat4(1.0f), m_Positions[0].position);
+			return m_Positions[0].position;
 
-		int p0Index = GetPositionIndex(animationTime);
+		int p0Index = cursor = GetPositionIndex(animationTime, cursor);
 		int p1Index = p0Index + 1;
 		float scaleFactor = GetScaleFactor(m_Positions[p0Index].timeStamp,
 			m_Positions[p1Index].timeStamp, animationTime);
-		glm::vec3 finalPosition = glm::mix(m_Positions[p0Index].position, m_Positions[p1Index].position
+		return glm::mix(m_Positions[p0Index].position, m_Positions[p1Index].position
 			, scaleFactor);
-		return glm::translate(glm::mat4(1.0f), finalPosition);
 	}
 
-	glm::mat4 InterpolateRotation(float animationTime)
+	glm::quat InterpolatedRotation(float animationTime, int& cursor) const
 	{
 		if (1 == m_NumRotations)
-		{
-			auto rotation = glm::normalize(m_Rotations[0].orientation);
-			return glm::toMat4(rotation);
-		}
+			return glm::normalize(m_Rotations[0].orientation);
 
-		int p0Index = GetRotationIndex(animationTime);
+		int p0Index = cursor = GetRotationIndex(animationTime, cursor);
 		int p1Index = p0Index + 1;
 		float scaleFactor = GetScaleFactor(m_Rotations[p0Index].timeStamp,
 			m_Rotations[p1Index].timeStamp, animationTime);
 		glm::quat finalRotation = glm::slerp(m_Rotations[p0Index].orientation, m_Rotations[p1Index].orientation
 			, scaleFactor);
-		finalRotation = glm::normalize(finalRotation);
-		return glm::toMat4(finalRotation);
-
+		return glm::normalize(finalRotation);
 	}
 
-	glm::mat4 InterpolateScaling(float animationTime)
+	glm::vec3 InterpolatedScale(float animationTime, int& cursor) const
 	{
 		if (1 == m_NumScalings)
-			return glm::scale(glm::mat4(1.0f), m_Scales[0].scale);
+			return m_Scales[0].scale;
 
-		int p0Index = GetScaleIndex(animationTime);
+		int p0Index = cursor = GetScaleIndex(animationTime, cursor);
 		int p1Index = p0Index + 1;
 		float scaleFactor = GetScaleFactor(m_Scales[p0Index].timeStamp,
 			m_Scales[p1Index].timeStamp, animationTime);
-		glm::vec3 finalScale = glm::mix(m_Scales[p0Index].scale, m_Scales[p1Index].scale
+		return glm::mix(m_Scales[p0Index].scale, m_Scales[p1Index].scale
 			, scaleFactor);
-		return glm::scale(glm::mat4(1.0f), finalScale);
 	}
 
+	/* Greedy key reduction: starting from the last kept key, extends the segment as long as interpolating
+	   between its (decoded) ends reproduces every original key inside it, keeps the key before the first
+	   miss and starts over from there. fits(first, last) checks one segment. Returns the kept key indices */
+	template<typename Fits>
+	static std::vector<int> ReduceKeys(int count, Fits fits)
+	{
+		std::vector<int> kept(1, 0);
+		for (int last = 2; last < count; last++)
+		{
+			if (!fits(kept.back(), last))
+				kept.push_back(last - 1);
+		}
+		if (count > 1)
+			kept.push_back(count - 1);
+		return kept;
+	}
+
+	static bool WithinTolerance(const glm::vec3& a, const glm::vec3& b, float tolerance)
+	{
+		const glm::vec3 difference = glm::abs(a - b);
+		return std::max(difference.x, std::max(difference.y, difference.z)) <= tolerance;
+	}
+
+	template<typename Key, typename Value>
+	static CompressedTrack CompressVectors(const std::vector<Key>& keys, float tolerance, Value value)
+	{
+		CompressedTrack track;
+		const int count = (int)keys.size();
+		glm::vec3 low = value(keys[0]), high = low;
+		for (const Key& key : keys)
+		{
+			low = glm::min(low, value(key));
+			high = glm::max(high, value(key));
+		}
+		track.min = low;
+		track.step = (high - low) / 65535.0f;
+
+		// quantize everything first, the reduction compares what decoding will return
+		std::vector<uint16_t> quantized(count * 3);
+		std::vector<glm::vec3> decoded(count);
+		for (int i = 0; i < count; i++)
+		{
+			for (int c = 0; c < 3; c++)
+				quantized[i * 3 + c] = track.step[c] > 0.0f
+					? (uint16_t)std::lround(glm::clamp((value(keys[i])[c] - low[c]) / track.step[c], 0.0f, 65535.0f)) : 0;
+			decoded[i] = low + glm::vec3(quantized[i * 3], quantized[i * 3 + 1], quantized[i * 3 + 2]) * track.step;
+		}
+
+		std::vector<int> kept;
+		bool constant = true;
+		for (int i = 0; i < count && constant; i++)
+			constant = WithinTolerance(decoded[0], value(keys[i]), tolerance);
+		if (constant)
+			kept.push_back(0);
+		else
+			kept = ReduceKeys(count, [&](int first, int last)
+			{
+				for (int i = first + 1; i < last; i++)
+				{
+					const float factor = GetScaleFactor(keys[first].timeStamp, keys[last].timeStamp, keys[i].timeStamp);
+					if (!WithinTolerance(glm::mix(decoded[first], decoded[last], factor), value(keys[i]), tolerance))
+						return false;
+				}
+				return true;
+			});
+
+		for (int i : kept)
+		{
+			track.times.push_back(keys[i].timeStamp);
+			track.values.insert(track.values.end(), &quantized[i * 3], &quantized[i * 3] + 3);
+		}
+		return track;
+	}
+
+	static CompressedTrack CompressRotations(const std::vector<KeyRotation>& keys, float tolerance)
+	{
+		CompressedTrack track;
+		const int count = (int)keys.size();
+		std::vector<uint16_t> quantized(count * 3);
+		std::vector<glm::quat> decoded(count);
+		for (int i = 0; i < count; i++)
+		{
+			EncodeRotation(keys[i].orientation, &quantized[i * 3]);
+			decoded[i] = DecodeRotation(&quantized[i * 3]);
+		}
+
+		std::vector<int> kept;
+		bool constant = true;
+		for (int i = 0; i < count && constant; i++)
+			constant = AngleBetween(decoded[0], keys[i].orientation) <= tolerance;
+		if (constant)
+			kept.push_back(0);
+		else
+			kept = ReduceKeys(count, [&](int first, int last)
+			{
+				for (int i = first + 1; i < last; i++)
+				{
+					const float factor = GetScaleFactor(keys[first].timeStamp, keys[last].timeStamp, keys[i].timeStamp);
+					if (AngleBetween(glm::slerp(decoded[first], decoded[last], factor), keys[i].orientation) > tolerance)
+						return false;
+				}
+				return true;
+			});
+
+		for (int i : kept)
+		{
+			track.times.push_back(keys[i].timeStamp);
+			track.values.insert(track.values.end(), &quantized[i * 3], &quantized[i * 3] + 3);
+		}
+		return track;
+	}
+
+	glm::vec3 InterpolatedVector(const CompressedTrack& track, float animationTime, int& cursor) const
+	{
+		if (track.times.size() == 1)
+			return DecodeVector(track, 0);
+
+		int p0Index = cursor = FindKeyIndex(track.times, animationTime, cursor);
+		float scaleFactor = GetScaleFactor(track.times[p0Index], track.times[p0Index + 1], animationTime);
+		return glm::mix(DecodeVector(track, p0Index), DecodeVector(track, p0Index + 1), scaleFactor);
+	}
+
+	glm::quat InterpolatedRotation(const CompressedTrack& track, float animationTime, int& cursor) const
+	{
+		if (track.times.size() == 1)
+			return DecodeRotation(&track.values[0]);
+
+		int p0Index = cursor = FindKeyIndex(track.times, animationTime, cursor);
+		float scaleFactor = GetScaleFactor(track.times[p0Index], track.times[p0Index + 1], animationTime);
+		glm::quat finalRotation = glm::slerp(DecodeRotation(&track.values[p0Index * 3]),
+			DecodeRotation(&track.values[(p0Index + 1) * 3]), scaleFactor);
+		return glm::normalize(finalRotation);
+	}
+
+	static constexpr float SQRT2 = 1.41421356f;
+
 	std::vector<KeyPosition> m_Positions;
 	std::vector<KeyRotation> m_Rotations;
 	std::vector<KeyScale> m_Scales;
@@ -184,5 +583,11 @@ private:
 	glm::mat4 m_LocalTransform;
 	std::string m_Name;
 	int m_ID;
+	BoneCursor m_Cursor; // used by Update()
+	float m_KeysPerTick = 0.0f; // > 0 once resampled to a fixed rate
+	bool m_Compressed = false;  // the keys live in the compressed tracks below
+	CompressedTrack m_CompressedPositions;
+	CompressedTrack m_CompressedRotations;
+	CompressedTrack m_CompressedScales;
 };
 
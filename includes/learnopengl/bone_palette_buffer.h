@@ -0,0 +1,138 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+/* Bone palettes of any size for any number of characters in a texture buffer, so the vertex shader reads a matrix
+   as four RGBA32F texels with texelFetch instead of from a mat4 uniform array limited to a hundred bones:
+
+	uniform samplerBuffer bonePalette;
+	uniform int paletteOffset; // Upload()'s return value + the character's first matrix in what was uploaded
+
+   The buffer is a ring of one segment per frame in flight. Upload() writes a frame's palettes into the next segment
+   with a single copy, after waiting on the fence of the frame that used that segment before, so the CPU never
+   overwrites matrices the GPU is still reading and never stalls behind the frame being drawn. With GL 4.4 the ring is
+   mapped once and stays mapped (glBufferStorage), before that each upload maps its segment unsynchronized. */
+class BonePaletteBuffer
+{
+public:
+	BonePaletteBuffer(int framesInFlight = 3)
+		: m_Fences(std::max(framesInFlight, 1), nullptr)
+	{
+		glGenBuffers(1, &m_Buffer);
+		glGenTextures(1, &m_Texture);
+	}
+
+	~BonePaletteBuffer()
+	{
+		Release();
+		glDeleteTextures(1, &m_Texture);
+		glDeleteBuffers(1, &m_Buffer);
+	}
+
+	BonePaletteBuffer(const BonePaletteBuffer&) = delete;
+	BonePaletteBuffer& operator=(const BonePaletteBuffer&) = delete;
+
+	/* Copies count matrices into the ring, once per frame before the draws that read them. Returns the index of the
+	   first matrix in the buffer, the base of this frame's paletteOffset values. Also fences the previous frame's
+	   segment: every draw reading it was issued by now */
+	int Upload(const glm::mat4* matrices, size_t count)
+	{
+		if (m_Previous >= 0)
+			m_Fences[m_Previous] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		if (count > m_SegmentSize)
+			Allocate(count);
+
+		const int segment = (m_Previous + 1) % (int)m_Fences.size();
+		Wait(segment);
+		const size_t offset = segment * m_SegmentSize * sizeof(glm::mat4);
+		const size_t bytes = count * sizeof(glm::mat4);
+		if (m_Mapped)
+			memcpy(m_Mapped + offset, matrices, bytes);
+		else if (bytes > 0)
+		{
+			glBindBuffer(GL_TEXTURE_BUFFER, m_Buffer);
+			void* target = glMapBufferRange(GL_TEXTURE_BUFFER, offset, bytes,
+				GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+			memcpy(target, matrices, bytes);
+			glUnmapBuffer(GL_TEXTURE_BUFFER);
+			glBindBuffer(GL_TEXTURE_BUFFER, 0);
+		}
+		m_Previous = segment;
+		return int(segment * m_SegmentSize);
+	}
+
+	/* binds the palette texture to texture unit unit, for the samplerBuffer uniform */
+	void Bind(int unit) const
+	{
+		glActiveTexture(GL_TEXTURE0 + unit);
+		glBindTexture(GL_TEXTURE_BUFFER, m_Texture);
+		glActiveTexture(GL_TEXTURE0);
+	}
+
+	/* matrices per frame that fit without growing the ring */
+	inline size_t GetCapacity() const { return m_SegmentSize; }
+	inline bool IsPersistent() const { return m_Mapped != nullptr; }
+
+private:
+	/* (re)creates the ring for at least count matrices per frame; growing is rare, so it simply waits for the GPU */
+	void Allocate(size_t count)
+	{
+		Release();
+		m_SegmentSize = std::max(count, m_SegmentSize * 2);
+		const GLsizeiptr size = GLsizeiptr(m_SegmentSize * m_Fences.size() * sizeof(glm::mat4));
+
+		// a buffer storage can't be resized, so the old buffer goes
+		glDeleteBuffers(1, &m_Buffer);
+		glGenBuffers(1, &m_Buffer);
+		glBindBuffer(GL_TEXTURE_BUFFER, m_Buffer);
+		if (GLAD_GL_VERSION_4_4)
+		{
+			const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+			glBufferStorage(GL_TEXTURE_BUFFER, size, nullptr, flags);
+			m_Mapped = (char*)glMapBufferRange(GL_TEXTURE_BUFFER, 0, size, flags);
+		}
+		else
+			glBufferData(GL_TEXTURE_BUFFER, size, nullptr, GL_STREAM_DRAW);
+		glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+		glBindTexture(GL_TEXTURE_BUFFER, m_Texture);
+		glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, m_Buffer);
+		glBindTexture(GL_TEXTURE_BUFFER, 0);
+	}
+
+	/* waits for every segment and unmaps the ring */
+	void Release()
+	{
+		for (int segment = 0; segment < (int)m_Fences.size(); segment++)
+			Wait(segment);
+		if (m_Mapped)
+		{
+			glBindBuffer(GL_TEXTURE_BUFFER, m_Buffer);
+			glUnmapBuffer(GL_TEXTURE_BUFFER);
+			glBindBuffer(GL_TEXTURE_BUFFER, 0);
+			m_Mapped = nullptr;
+		}
+	}
+
+	void Wait(int segment)
+	{
+		GLsync& fence = m_Fences[segment];
+		if (!fence)
+			return;
+		while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000) == GL_TIMEOUT_EXPIRED)
+			;
+		glDeleteSync(fence);
+		fence = nullptr;
+	}
+
+	GLuint m_Buffer = 0;
+	GLuint m_Texture = 0;
+	std::vector<GLsync> m_Fences; // per segment, set once the draws reading it are issued
+	size_t m_SegmentSize = 0;     // in matrices
+	int m_Previous = -1;          // segment of the last upload
+	char* m_Mapped = nullptr;     // the whole ring while persistently mapped
+};
@@ -0,0 +1,164 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include <learnopengl/mesh.h>
+#include <learnopengl/thread_pool.h>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define CPU_SKINNING_AVX
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define CPU_SKINNING_SSE
+#endif
+
+/* Skinning on the CPU, e.g. for validating poses without a GPU or as a software fallback. Applies a palette of
+   final bone matrices (Animator::GetFinalBoneMatrices) to Vertex data the way anim_model.vs does: influences
+   with a bone id of -1 are skipped, and a vertex with any id past the palette keeps its bind pose. Normals are
+   transformed by the blended matrix and normalized. */
+namespace CpuSkinning
+{
+	/* one vertex at a time, the straightforward way: the golden output for SkinRange */
+	inline void SkinReference(const Vertex* vertices, size_t count, const glm::mat4* palette, int paletteSize,
+		glm::vec3* positions, glm::vec3* normals)
+	{
+		for (size_t v = 0; v < count; v++)
+		{
+			const Vertex& vertex = vertices[v];
+			glm::vec4 position(0.0f);
+			glm::vec3 normal(0.0f);
+			bool bindPose = false;
+			for (int i = 0; i < MAX_BONE_INFLUENCE; i++)
+			{
+				const int id = vertex.m_BoneIDs[i];
+				if (id < 0)
+					continue;
+				if (id >= paletteSize)
+				{
+					bindPose = true;
+					break;
+				}
+				position += palette[id] * glm::vec4(vertex.Position, 1.0f) * vertex.m_Weights[i];
+				normal += glm::mat3(palette[id]) * vertex.Normal * vertex.m_Weights[i];
+			}
+			if (bindPose)
+			{
+				position = glm::vec4(vertex.Position, 1.0f);
+				normal = vertex.Normal;
+			}
+			const float length2 = glm::dot(normal, normal);
+			positions[v] = glm::vec3(position);
+			normals[v] = length2 > 0.0f ? normal / std::sqrt(length2) : normal;
+		}
+	}
+
+	/* The vectorized kernel. Skinning is linear, so instead of transforming the vertex by every bone it blends
+	   the bone matrices first and transforms once: with AVX two columns are blended per instruction, with SSE
+	   one. Falls back to SkinReference without SSE */
+	inline void SkinRange(const Vertex* vertices, size_t count, const glm::mat4* palette, int paletteSize,
+		glm::vec3* positions, glm::vec3* normals)
+	{
+#if defined(CPU_SKINNING_AVX) || defined(CPU_SKINNING_SSE)
+		if (paletteSize <= 0)
+		{
+			SkinReference(vertices, count, palette, paletteSize, positions, normals);
+			return;
+		}
+		static_assert(MAX_BONE_INFLUENCE == 4, "the kernel loads the bone ids and weights of a vertex as one vector");
+		const float* matrices = &palette[0][0][0];
+		const __m128i noBone = _mm_set1_epi32(-1), lastBone = _mm_set1_epi32(paletteSize - 1);
+		for (size_t v = 0; v < count; v++)
+		{
+			const Vertex& vertex = vertices[v];
+			const __m128i ids = _mm_loadu_si128(reinterpret_cast<const __m128i*>(vertex.m_BoneIDs));
+			if (_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(ids, lastBone))))
+			{
+				positions[v] = vertex.Position;
+				const float length2 = glm::dot(vertex.Normal, vertex.Normal);
+				normals[v] = length2 > 0.0f ? vertex.Normal / std::sqrt(length2) : vertex.Normal;
+				continue;
+			}
+			// unused influences (-1) become bone 0 with weight 0: blending all four always is cheaper than
+			// branching on the number of influences, which changes from vertex to vertex
+			const __m128i used = _mm_cmpgt_epi32(ids, noBone);
+			alignas(16) int index[4];
+			alignas(16) float weights[4];
+			_mm_store_si128(reinterpret_cast<__m128i*>(index), _mm_and_si128(ids, used));
+			_mm_store_ps(weights, _mm_and_ps(_mm_loadu_ps(vertex.m_Weights), _mm_castsi128_ps(used)));
+
+#if defined(CPU_SKINNING_AVX)
+			__m256 columns01 = _mm256_setzero_ps(), columns23 = _mm256_setzero_ps();
+#else
+			__m128 column0 = _mm_setzero_ps(), column1 = _mm_setzero_ps(), column2 = _mm_setzero_ps(), column3 = _mm_setzero_ps();
+#endif
+			for (int i = 0; i < MAX_BONE_INFLUENCE; i++)
+			{
+				const float* matrix = matrices + index[i] * 16;
+#if defined(CPU_SKINNING_AVX)
+				const __m256 weight = _mm256_set1_ps(weights[i]);
+				columns01 = _mm256_add_ps(columns01, _mm256_mul_ps(weight, _mm256_loadu_ps(matrix)));
+				columns23 = _mm256_add_ps(columns23, _mm256_mul_ps(weight, _mm256_loadu_ps(matrix + 8)));
+#else
+				const __m128 weight = _mm_set1_ps(weights[i]);
+				column0 = _mm_add_ps(column0, _mm_mul_ps(weight, _mm_loadu_ps(matrix)));
+				column1 = _mm_add_ps(column1, _mm_mul_ps(weight, _mm_loadu_ps(matrix + 4)));
+				column2 = _mm_add_ps(column2, _mm_mul_ps(weight, _mm_loadu_ps(matrix + 8)));
+				column3 = _mm_add_ps(column3, _mm_mul_ps(weight, _mm_loadu_ps(matrix + 12)));
+#endif
+			}
+
+#if defined(CPU_SKINNING_AVX)
+			// (column0 * x + column1 * y) + (column2 * z + column3), the halves added at the end
+			const __m256 position = _mm256_add_ps(
+				_mm256_mul_ps(columns01, _mm256_setr_ps(vertex.Position.x, vertex.Position.x, vertex.Position.x, vertex.Position.x,
+					vertex.Position.y, vertex.Position.y, vertex.Position.y, vertex.Position.y)),
+				_mm256_mul_ps(columns23, _mm256_setr_ps(vertex.Position.z, vertex.Position.z, vertex.Position.z, vertex.Position.z,
+					1.0f, 1.0f, 1.0f, 1.0f)));
+			const __m256 normal = _mm256_add_ps(
+				_mm256_mul_ps(columns01, _mm256_setr_ps(vertex.Normal.x, vertex.Normal.x, vertex.Normal.x, vertex.Normal.x,
+					vertex.Normal.y, vertex.Normal.y, vertex.Normal.y, vertex.Normal.y)),
+				_mm256_mul_ps(columns23, _mm256_setr_ps(vertex.Normal.z, vertex.Normal.z, vertex.Normal.z, vertex.Normal.z,
+					0.0f, 0.0f, 0.0f, 0.0f)));
+			const __m128 skinnedPosition = _mm_add_ps(_mm256_castps256_ps128(position), _mm256_extractf128_ps(position, 1));
+			__m128 skinnedNormal = _mm_add_ps(_mm256_castps256_ps128(normal), _mm256_extractf128_ps(normal, 1));
+#else
+			const __m128 skinnedPosition = _mm_add_ps(
+				_mm_add_ps(_mm_mul_ps(column0, _mm_set1_ps(vertex.Position.x)), _mm_mul_ps(column1, _mm_set1_ps(vertex.Position.y))),
+				_mm_add_ps(_mm_mul_ps(column2, _mm_set1_ps(vertex.Position.z)), column3));
+			__m128 skinnedNormal = _mm_add_ps(
+				_mm_add_ps(_mm_mul_ps(column0, _mm_set1_ps(vertex.Normal.x)), _mm_mul_ps(column1, _mm_set1_ps(vertex.Normal.y))),
+				_mm_mul_ps(column2, _mm_set1_ps(vertex.Normal.z)));
+#endif
+			float position4[4], normal4[4];
+			_mm_storeu_ps(position4, skinnedPosition);
+			_mm_storeu_ps(normal4, skinnedNormal);
+			const float length2 = normal4[0] * normal4[0] + normal4[1] * normal4[1] + normal4[2] * normal4[2];
+			const float scale = length2 > 0.0f ? 1.0f / std::sqrt(length2) : 1.0f;
+			positions[v] = glm::vec3(position4[0], position4[1], position4[2]);
+			normals[v] = glm::vec3(normal4[0] * scale, normal4[1] * scale, normal4[2] * scale);
+		}
+#else
+		SkinReference(vertices, count, palette, paletteSize, positions, normals);
+#endif
+	}
+
+	/* SkinRange over all vertices, split into blocks of vertices that the pool's threads take in turn;
+	   positions and normals are resized to the vertex count */
+	inline void Skin(const std::vector<Vertex>& vertices, const std::vector<glm::mat4>& palette,
+		std::vector<glm::vec3>& positions, std::vector<glm::vec3>& normals, ThreadPool& pool = ThreadPool::shared())
+	{
+		const size_t blockSize = 4096;
+		positions.resize(vertices.size());
+		normals.resize(vertices.size());
+		const size_t blocks = (vertices.size() + blockSize - 1) / blockSize;
+		pool.parallelFor(blocks, [&](size_t block)
+		{
+			const size_t first = block * blockSize;
+			const size_t count = std::min(blockSize, vertices.size() - first);
+			SkinRange(&vertices[first], count, palette.data(), (int)palette.size(), &positions[first], &normals[first]);
+		});
+	}
+}
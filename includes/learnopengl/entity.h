@@ -283,6 +283,8 @@ struct AABB : public BoundingVolume
 		return vertice;
 	}
 
+	using BoundingVolume::isOnFrustum;
+
 	//see https://gdbooks.gitbooks.io/3dcollisions/content/Chapter2/static_aabb_plane.html
 	bool isOnOrForwardPlane(const Plane& plane) const final
 	{
@@ -0,0 +1,213 @@
+#ifndef FLAT_SCENE_H
+#define FLAT_SCENE_H
+
+#include <glm/glm.hpp> //glm::mat4
+
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+//Scene graph storage without pointers, an alternative to Entity for big scenes. Nodes are kept in flat arrays in
+//parent-before-child order (a node can only be added after its parent), so one forward pass over the arrays
+//always reaches a parent before any of its children. Local transforms are stored per attribute (one array for the
+//positions, one for the rotations, ...) and world matrices as affine 3x4 rows, which is all update() has to touch.
+class FlatScene
+{
+public:
+	typedef uint32_t Node;
+
+	//Implicit identity node at index 0, top level nodes are its children
+	static const Node ROOT = 0;
+
+	//Row-major 3x4 matrix, the last row of the affine matrix is always (0, 0, 0, 1)
+	struct Affine
+	{
+		float m[3][4];
+	};
+
+	FlatScene()
+	{
+		parents.push_back(Node(ROOT));
+		positions.emplace_back(0.0f);
+		rotations.emplace_back(0.0f);
+		scales.emplace_back(1.0f);
+		locals.push_back(identity());
+		worlds.push_back(identity());
+		flags.push_back(0);
+	}
+
+	void reserve(size_t count)
+	{
+		parents.reserve(count + 1);
+		positions.reserve(count + 1);
+		rotations.reserve(count + 1);
+		scales.reserve(count + 1);
+		locals.reserve(count + 1);
+		worlds.reserve(count + 1);
+		flags.reserve(count + 1);
+	}
+
+	//Appends a node; its world matrix is valid after the next update()
+	Node add(Node parent = ROOT)
+	{
+		assert(parent < parents.size());
+		parents.push_back(parent);
+		positions.emplace_back(0.0f);
+		rotations.emplace_back(0.0f);
+		scales.emplace_back(1.0f);
+		locals.push_back(identity());
+		worlds.push_back(identity());
+		flags.push_back(LOCAL_DIRTY | WORLD_DIRTY);
+		anyDirty = true;
+		return static_cast<Node>(parents.size() - 1);
+	}
+
+	void setLocalPosition(Node node, const glm::vec3& newPosition)
+	{
+		positions[node] = newPosition;
+		markDirty(node);
+	}
+
+	//Euler angles in degrees, applied Y * X * Z like Transform
+	void setLocalRotation(Node node, const glm::vec3& newRotation)
+	{
+		rotations[node] = newRotation;
+		markDirty(node);
+	}
+
+	void setLocalScale(Node node, const glm::vec3& newScale)
+	{
+		scales[node] = newScale;
+		markDirty(node);
+	}
+
+	const glm::vec3& getLocalPosition(Node node) const { return positions[node]; }
+	const glm::vec3& getLocalRotation(Node node) const { return rotations[node]; }
+	const glm::vec3& getLocalScale(Node node) const { return scales[node]; }
+	Node getParent(Node node) const { return parents[node]; }
+
+	const Affine& getWorldAffine(Node node) const { return worlds[node]; }
+
+	glm::mat4 getModelMatrix(Node node) const
+	{
+		const Affine& w = worlds[node];
+		return glm::mat4(w.m[0][0], w.m[1][0], w.m[2][0], 0.0f,
+			w.m[0][1], w.m[1][1], w.m[2][1], 0.0f,
+			w.m[0][2], w.m[1][2], w.m[2][2], 0.0f,
+			w.m[0][3], w.m[1][3], w.m[2][3], 1.0f);
+	}
+
+	glm::vec3 getGlobalPosition(Node node) const
+	{
+		const Affine& w = worlds[node];
+		return { w.m[0][3], w.m[1][3], w.m[2][3] };
+	}
+
+	//Number of nodes, including ROOT
+	size_t size() const { return parents.size(); }
+
+	//Recomputes the world matrix of every node whose local transform, or the one of an ancestor, changed.
+	//Returns false if nothing changed since the last update
+	bool update()
+	{
+		if (!anyDirty)
+			return false;
+
+		const size_t count = parents.size();
+		const Node* parent = parents.data();
+		uint8_t* dirty = flags.data();
+
+		//A changed node invalidates its whole subtree. Parents come first, so one pass propagates over any depth
+		for (size_t i = 1; i < count; i++)
+			dirty[i] |= dirty[parent[i]] & WORLD_DIRTY;
+
+		Affine* local = locals.data();
+		Affine* world = worlds.data();
+		for (size_t i = 1; i < count; i++)
+		{
+			if (!dirty[i])
+				continue;
+			if (dirty[i] & LOCAL_DIRTY)
+				local[i] = composeTRS(positions[i], rotations[i], scales[i]);
+			multiply(world[parent[i]], local[i], world[i]);
+		}
+
+		memset(dirty, 0, count);
+		anyDirty = false;
+		return true;
+	}
+
+	//translation * rotationY * rotationX * rotationZ * scale, written out instead of multiplying three glm::rotate
+	static Affine composeTRS(const glm::vec3& position, const glm::vec3& eulerDegrees, const glm::vec3& scale)
+	{
+		const float ax = glm::radians(eulerDegrees.x), ay = glm::radians(eulerDegrees.y), az = glm::radians(eulerDegrees.z);
+		const float sx = std::sin(ax), cx = std::cos(ax);
+		const float sy = std::sin(ay), cy = std::cos(ay);
+		const float sz = std::sin(az), cz = std::cos(az);
+
+		Affine out;
+		out.m[0][0] = (cy * cz + sy * sx * sz) * scale.x;
+		out.m[0][1] = (sy * sx * cz - cy * sz) * scale.y;
+		out.m[0][2] = sy * cx * scale.z;
+		out.m[0][3] = position.x;
+
+		out.m[1][0] = cx * sz * scale.x;
+		out.m[1][1] = cx * cz * scale.y;
+		out.m[1][2] = -sx * scale.z;
+		out.m[1][3] = position.y;
+
+		out.m[2][0] = (cy * sx * sz - sy * cz) * scale.x;
+		out.m[2][1] = (sy * sz + cy * sx * cz) * scale.y;
+		out.m[2][2] = cy * cx * scale.z;
+		out.m[2][3] = position.z;
+		return out;
+	}
+
+	//out = a * b for affine matrices. Each row is a 4 wide multiply-add of the rows of b, which compilers turn into SIMD
+	static void multiply(const Affine& a, const Affine& b, Affine& out)
+	{
+		for (int r = 0; r < 3; r++)
+		{
+			float row[4];
+			for (int c = 0; c < 4; c++)
+				row[c] = a.m[r][0] * b.m[0][c] + a.m[r][1] * b.m[1][c] + a.m[r][2] * b.m[2][c];
+			row[3] += a.m[r][3];
+			for (int c = 0; c < 4; c++)
+				out.m[r][c] = row[c];
+		}
+	}
+
+	static Affine identity()
+	{
+		Affine out;
+		memset(&out, 0, sizeof(out));
+		out.m[0][0] = out.m[1][1] = out.m[2][2] = 1.0f;
+		return out;
+	}
+
+private:
+	enum : uint8_t
+	{
+		LOCAL_DIRTY = 1 << 0, //Own position/rotation/scale changed
+		WORLD_DIRTY = 1 << 1  //World matrix has to be recomputed
+	};
+
+	void markDirty(Node node)
+	{
+		assert(node != ROOT);
+		flags[node] = LOCAL_DIRTY | WORLD_DIRTY;
+		anyDirty = true;
+	}
+
+	std::vector<Node> parents;
+	std::vector<glm::vec3> positions;
+	std::vector<glm::vec3> rotations; //In degrees
+	std::vector<glm::vec3> scales;
+	std::vector<Affine> locals;
+	std::vector<Affine> worlds;
+	std::vector<uint8_t> flags;
+	bool anyDirty = false;
+};
+#endif
@@ -0,0 +1,164 @@
+#ifndef FRUSTUM_CULL_H
+#define FRUSTUM_CULL_H
+
+#include <learnopengl/entity.h> //Frustum, AABB
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define FRUSTUM_CULL_AVX
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define FRUSTUM_CULL_SSE
+#endif
+
+//World space boxes as structure of arrays, one array per component, so the culler can load 4 (SSE) or 8 (AVX)
+//boxes with one instruction per component
+struct AABBArray
+{
+	std::vector<float> centerX, centerY, centerZ;
+	std::vector<float> extentX, extentY, extentZ;
+
+	void resize(size_t count)
+	{
+		centerX.resize(count); centerY.resize(count); centerZ.resize(count);
+		extentX.resize(count); extentY.resize(count); extentZ.resize(count);
+	}
+
+	size_t size() const { return centerX.size(); }
+
+	void set(size_t i, const glm::vec3& center, const glm::vec3& extents)
+	{
+		centerX[i] = center.x; centerY[i] = center.y; centerZ[i] = center.z;
+		extentX[i] = extents.x; extentY[i] = extents.y; extentZ[i] = extents.z;
+	}
+
+	void set(size_t i, const AABB& box) { set(i, box.center, box.extents); }
+};
+
+//Frustum planes split by component. The absolute normals are kept as well: the projected radius of a box
+//onto a plane is extents . |normal|
+struct FrustumPlanes
+{
+	float normalX[6], normalY[6], normalZ[6];
+	float absX[6], absY[6], absZ[6];
+	float distance[6];
+
+	explicit FrustumPlanes(const Frustum& frustum)
+	{
+		const Plane* planes[6] = { &frustum.leftFace, &frustum.rightFace, &frustum.topFace,
+			&frustum.bottomFace, &frustum.nearFace, &frustum.farFace };
+		for (int p = 0; p < 6; p++)
+		{
+			normalX[p] = planes[p]->normal.x;
+			normalY[p] = planes[p]->normal.y;
+			normalZ[p] = planes[p]->normal.z;
+			absX[p] = std::abs(normalX[p]);
+			absY[p] = std::abs(normalY[p]);
+			absZ[p] = std::abs(normalZ[p]);
+			distance[p] = planes[p]->distance;
+		}
+	}
+
+	//Same test as AABB::isOnFrustum for a single box, in the operation order of the SIMD loops
+	bool isOnFrustum(float cx, float cy, float cz, float ex, float ey, float ez) const
+	{
+		for (int p = 0; p < 6; p++)
+		{
+			const float d = cx * normalX[p] - distance[p] + cy * normalY[p] + cz * normalZ[p] + ex * absX[p] + ey * absY[p] + ez * absZ[p];
+			if (!(d >= 0.f))
+				return false;
+		}
+		return true;
+	}
+};
+
+inline uint32_t countBits(uint32_t bits)
+{
+	bits = bits - ((bits >> 1) & 0x55555555u);
+	bits = (bits & 0x33333333u) + ((bits >> 2) & 0x33333333u);
+	return (((bits + (bits >> 4)) & 0x0F0F0F0Fu) * 0x01010101u) >> 24;
+}
+
+//Tests every box of boxes against the frustum; bit i of visible (word i / 32) is set if box i is at least partially
+//inside. Returns the number of visible boxes. visible is resized, so a reused vector doesn't allocate.
+inline size_t cullAABBs(const Frustum& frustum, const AABBArray& boxes, std::vector<uint32_t>& visible)
+{
+	const FrustumPlanes planes(frustum);
+	const size_t count = boxes.size();
+	visible.assign((count + 31) / 32, 0);
+
+	const float* cx = boxes.centerX.data();
+	const float* cy = boxes.centerY.data();
+	const float* cz = boxes.centerZ.data();
+	const float* ex = boxes.extentX.data();
+	const float* ey = boxes.extentY.data();
+	const float* ez = boxes.extentZ.data();
+	uint32_t* words = visible.data();
+	size_t visibleCount = 0;
+	size_t i = 0;
+
+#if defined(FRUSTUM_CULL_AVX)
+	for (; i + 8 <= count; i += 8)
+	{
+		const __m256 x = _mm256_loadu_ps(cx + i), y = _mm256_loadu_ps(cy + i), z = _mm256_loadu_ps(cz + i);
+		const __m256 sx = _mm256_loadu_ps(ex + i), sy = _mm256_loadu_ps(ey + i), sz = _mm256_loadu_ps(ez + i);
+		__m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+		for (int p = 0; p < 6; p++)
+		{
+			//distance + r >= 0 <=> the box reaches the positive side of the plane
+			__m256 d = _mm256_sub_ps(_mm256_mul_ps(x, _mm256_set1_ps(planes.normalX[p])), _mm256_set1_ps(planes.distance[p]));
+			d = _mm256_add_ps(d, _mm256_mul_ps(y, _mm256_set1_ps(planes.normalY[p])));
+			d = _mm256_add_ps(d, _mm256_mul_ps(z, _mm256_set1_ps(planes.normalZ[p])));
+			d = _mm256_add_ps(d, _mm256_mul_ps(sx, _mm256_set1_ps(planes.absX[p])));
+			d = _mm256_add_ps(d, _mm256_mul_ps(sy, _mm256_set1_ps(planes.absY[p])));
+			d = _mm256_add_ps(d, _mm256_mul_ps(sz, _mm256_set1_ps(planes.absZ[p])));
+			inside = _mm256_and_ps(inside, _mm256_cmp_ps(d, _mm256_setzero_ps(), _CMP_GE_OQ));
+		}
+		const uint32_t bits = static_cast<uint32_t>(_mm256_movemask_ps(inside));
+		words[i / 32] |= bits << (i % 32);
+		visibleCount += countBits(bits);
+	}
+#elif defined(FRUSTUM_CULL_SSE)
+	for (; i + 4 <= count; i += 4)
+	{
+		const __m128 x = _mm_loadu_ps(cx + i), y = _mm_loadu_ps(cy + i), z = _mm_loadu_ps(cz + i);
+		const __m128 sx = _mm_loadu_ps(ex + i), sy = _mm_loadu_ps(ey + i), sz = _mm_loadu_ps(ez + i);
+		__m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+		for (int p = 0; p < 6; p++)
+		{
+			//distance + r >= 0 <=> the box reaches the positive side of the plane
+			__m128 d = _mm_sub_ps(_mm_mul_ps(x, _mm_set1_ps(planes.normalX[p])), _mm_set1_ps(planes.distance[p]));
+			d = _mm_add_ps(d, _mm_mul_ps(y, _mm_set1_ps(planes.normalY[p])));
+			d = _mm_add_ps(d, _mm_mul_ps(z, _mm_set1_ps(planes.normalZ[p])));
+			d = _mm_add_ps(d, _mm_mul_ps(sx, _mm_set1_ps(planes.absX[p])));
+			d = _mm_add_ps(d, _mm_mul_ps(sy, _mm_set1_ps(planes.absY[p])));
+			d = _mm_add_ps(d, _mm_mul_ps(sz, _mm_set1_ps(planes.absZ[p])));
+			inside = _mm_and_ps(inside, _mm_cmpge_ps(d, _mm_setzero_ps()));
+		}
+		const uint32_t bits = static_cast<uint32_t>(_mm_movemask_ps(inside));
+		words[i / 32] |= bits << (i % 32);
+		visibleCount += countBits(bits);
+	}
+#endif
+
+	//What is left after the last full batch, or everything without SSE
+	for (; i < count; i++)
+	{
+		if (planes.isOnFrustum(cx[i], cy[i], cz[i], ex[i], ey[i], ez[i]))
+		{
+			words[i / 32] |= 1u << (i % 32);
+			visibleCount++;
+		}
+	}
+	return visibleCount;
+}
+
+inline bool isVisible(const std::vector<uint32_t>& visible, size_t i)
+{
+	return (visible[i / 32] >> (i % 32)) & 1;
+}
+#endif
@@ -0,0 +1,460 @@
+#ifndef GLYPH_ATLAS_H
+#define GLYPH_ATLAS_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <ft2build.h>
+#include FT_FREETYPE_H
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+// Packs rectangles into a fixed size area bottom-left first. The skyline is the top edge of what was packed so
+// far, as horizontal segments from left to right; a rectangle goes where it ends up lowest, resting on the
+// segments below it. Wastes little space on glyphs, whose heights vary a lot less than their count.
+class SkylinePacker
+{
+public:
+    SkylinePacker(int width, int height) : width(width), height(height), skyline(1, Segment{ 0, 0, width }) { }
+
+    // finds room for a w x h rectangle; false if there is none
+    bool insert(int w, int h, glm::ivec2 &position)
+    {
+        size_t best = skyline.size();
+        int bestBottom = INT_MAX, bestWidth = INT_MAX;
+        for (size_t i = 0; i < skyline.size() && skyline[i].x + w <= width; i++)
+        {
+            // the rectangle rests on the highest of the segments it spans
+            int y = 0;
+            for (size_t j = i; j < skyline.size() && skyline[j].x < skyline[i].x + w; j++)
+                y = std::max(y, skyline[j].y);
+            if (y + h > height)
+                continue;
+            if (y + h < bestBottom || (y + h == bestBottom && skyline[i].width < bestWidth))
+            {
+                best = i;
+                bestBottom = y + h;
+                bestWidth = skyline[i].width;
+            }
+        }
+        if (best == skyline.size())
+            return false;
+        position = glm::ivec2(skyline[best].x, bestBottom - h);
+
+        // the rectangle's top becomes a segment, cutting away what it covers of the ones after it
+        skyline.insert(skyline.begin() + best, Segment{ position.x, bestBottom, w });
+        const int right = position.x + w;
+        for (size_t i = best + 1; i < skyline.size() && skyline[i].x < right; )
+        {
+            const int covered = std::min(right - skyline[i].x, skyline[i].width);
+            skyline[i].x += covered;
+            skyline[i].width -= covered;
+            if (skyline[i].width == 0)
+                skyline.erase(skyline.begin() + i);
+            else
+                break;
+        }
+        // merge neighbours of the same height
+        for (size_t i = 0; i + 1 < skyline.size(); )
+        {
+            if (skyline[i].y == skyline[i + 1].y)
+            {
+                skyline[i].width += skyline[i + 1].width;
+                skyline.erase(skyline.begin() + i + 1);
+            }
+            else
+                i++;
+        }
+        return true;
+    }
+
+private:
+    struct Segment
+    {
+        int x, y, width;
+    };
+    int width, height;
+    std::vector<Segment> skyline;
+};
+
+// what the texels of a GlyphAtlas hold
+enum class GlyphMode
+{
+    BITMAP,        // coverage, as FreeType renders it: sharp at the size it was rasterized at only
+    DISTANCE_FIELD // signed distance to the outline, 0.5 on the edge: sharp at any scale with a threshold in the shader
+};
+
+// The first 128 ASCII characters of a font, rasterized by FreeType into a single red-only texture: text of any
+// length then needs only this one texture bound (see TextBatch). The atlas is the smallest power of two size the
+// glyphs fit in, with a pixel of padding around every glyph so linear filtering doesn't bleed in its neighbours.
+// Distance fields are computed from glyphs rendered at 8 times the size, which takes a while, so they are cached
+// next to the font as "<font>.sdfcache" and only regenerated when the font or the size changes. Set
+// LOGL_NO_GLYPH_CACHE in the environment to always generate them.
+class GlyphAtlas
+{
+public:
+    struct Glyph
+    {
+        glm::ivec2 size;        // of the bitmap, in pixels
+        glm::ivec2 bearing;     // offset from the baseline to the left/top of the bitmap
+        unsigned int advance;   // horizontal offset to the next glyph, in 1/64 pixels
+        glm::vec2 uvMin, uvMax; // where the bitmap is in the atlas; uvMin is its top left
+    };
+
+    GlyphAtlas() = default;
+    GlyphAtlas(const GlyphAtlas&) = delete;
+    GlyphAtlas& operator=(const GlyphAtlas&) = delete;
+
+    ~GlyphAtlas()
+    {
+        if (id)
+            glDeleteTextures(1, &id);
+    }
+
+    // rasterizes the font at pixelSize pixels and uploads the atlas; prints what went wrong and returns false if
+    // the font couldn't be loaded
+    bool load(const std::string &font, unsigned int pixelSize, GlyphMode mode = GlyphMode::BITMAP)
+    {
+        glyphMode = mode;
+        rasterSize = pixelSize;
+        if (mode == GlyphMode::DISTANCE_FIELD && cacheEnabled() && readCache(font))
+        {
+            upload();
+            return true;
+        }
+
+        FT_Library ft;
+        if (FT_Init_FreeType(&ft)) // all functions return a value different than 0 whenever an error occurred
+        {
+            std::cout << "ERROR::FREETYPE: Could not init FreeType Library" << std::endl;
+            return false;
+        }
+        FT_Face face;
+        if (FT_New_Face(ft, font.c_str(), 0, &face))
+        {
+            std::cout << "ERROR::FREETYPE: Failed to load font" << std::endl;
+            FT_Done_FreeType(ft);
+            return false;
+        }
+        FT_Set_Pixel_Sizes(face, 0, mode == GlyphMode::DISTANCE_FIELD ? pixelSize * UPSAMPLE : pixelSize);
+
+        // rasterize everything first: the atlas size depends on all of the glyphs
+        std::vector<std::vector<unsigned char>> bitmaps(GLYPH_COUNT);
+        for (unsigned int c = 0; c < GLYPH_COUNT; c++)
+        {
+            glyphs[c] = Glyph();
+            if (FT_Load_Char(face, c, FT_LOAD_RENDER))
+            {
+                std::cout << "ERROR::FREETYTPE: Failed to load Glyph" << std::endl;
+                continue;
+            }
+            if (mode == GlyphMode::DISTANCE_FIELD)
+            {
+                distanceField(face->glyph, glyphs[c], bitmaps[c]);
+                if (c == 'H')
+                    cap = int(std::lround(face->glyph->bitmap_top / double(UPSAMPLE)));
+                continue;
+            }
+            const FT_Bitmap &bitmap = face->glyph->bitmap;
+            glyphs[c].size = glm::ivec2(bitmap.width, bitmap.rows);
+            glyphs[c].bearing = glm::ivec2(face->glyph->bitmap_left, face->glyph->bitmap_top);
+            glyphs[c].advance = static_cast<unsigned int>(face->glyph->advance.x);
+            bitmaps[c].resize(bitmap.width * bitmap.rows);
+            for (unsigned int row = 0; row < bitmap.rows; row++)
+                memcpy(&bitmaps[c][row * bitmap.width], bitmap.buffer + row * bitmap.pitch, bitmap.width);
+        }
+        if (mode == GlyphMode::BITMAP)
+            cap = glyphs['H'].bearing.y;
+        FT_Done_Face(face);
+        FT_Done_FreeType(ft);
+
+        pack(bitmaps);
+        upload();
+        if (mode == GlyphMode::DISTANCE_FIELD && cacheEnabled())
+            writeCache(font);
+        return true;
+    }
+
+    const Glyph &glyph(char c) const
+    {
+        const unsigned char index = static_cast<unsigned char>(c);
+        return glyphs[index < GLYPH_COUNT ? index : 0];
+    }
+
+    // how far a capital letter reaches above the baseline, to align text at its top
+    int capHeight() const { return cap; }
+    // the size the glyph metrics are in: text at scale s is s * pixelSize() pixels high
+    unsigned int pixelSize() const { return rasterSize; }
+    GlyphMode mode() const { return glyphMode; }
+    unsigned int texture() const { return id; }
+    glm::ivec2 size() const { return glm::ivec2(width, height); }
+
+private:
+    static const unsigned int GLYPH_COUNT = 128;
+    static const int PADDING = 1;
+    // distance fields: glyphs are rendered this many times larger than the field's resolution
+    static const int UPSAMPLE = 8;
+
+    // how far in pixels a distance field reaches out of and into the outline; the shader can smooth or outline
+    // the text over that range, and the field stays usable when the text is drawn smaller than pixelSize
+    int spread() const { return std::max(2, int(rasterSize) / 8); }
+
+    // Turns a glyph rendered UPSAMPLE times too large into its distance field. Its box is the bitmap's rounded
+    // out to whole pixels of the field, grown by the spread on all sides; every texel holds the distance of its
+    // center to the outline, found with an exact Euclidean distance transform of the large bitmap
+    void distanceField(const FT_GlyphSlot slot, Glyph &glyph, std::vector<unsigned char> &field)
+    {
+        const FT_Bitmap &bitmap = slot->bitmap;
+        glyph.advance = static_cast<unsigned int>(slot->advance.x / UPSAMPLE);
+        if (bitmap.width == 0 || bitmap.rows == 0)
+            return;
+        auto floorDiv = [](int a, int b) { return a >= 0 ? a / b : -((-a + b - 1) / b); };
+        auto ceilDiv = [](int a, int b) { return a >= 0 ? (a + b - 1) / b : -(-a / b); };
+        const int margin = spread();
+        const int left = floorDiv(slot->bitmap_left, UPSAMPLE) - margin;
+        const int right = ceilDiv(slot->bitmap_left + int(bitmap.width), UPSAMPLE) + margin;
+        const int top = ceilDiv(slot->bitmap_top, UPSAMPLE) + margin;
+        const int bottom = floorDiv(slot->bitmap_top - int(bitmap.rows), UPSAMPLE) - margin;
+        glyph.size = glm::ivec2(right - left, top - bottom);
+        glyph.bearing = glm::ivec2(left, top);
+
+        // the large bitmap on a grid covering the whole box: inside where it covers at least half a pixel
+        const int w = glyph.size.x * UPSAMPLE, h = glyph.size.y * UPSAMPLE;
+        const int offsetX = slot->bitmap_left - left * UPSAMPLE, offsetY = top * UPSAMPLE - slot->bitmap_top;
+        std::vector<float> toInside(size_t(w) * h, FAR), toOutside(size_t(w) * h, 0.0f);
+        for (unsigned int y = 0; y < bitmap.rows; y++)
+            for (unsigned int x = 0; x < bitmap.width; x++)
+                if (bitmap.buffer[y * bitmap.pitch + x] >= 128)
+                {
+                    const size_t index = size_t(y + offsetY) * w + x + offsetX;
+                    toInside[index] = 0.0f;
+                    toOutside[index] = FAR;
+                }
+        distanceTransform(toInside, w, h);
+        distanceTransform(toOutside, w, h);
+
+        // positive inside; the outline lies half a pixel from the centers of the pixels on either side of it
+        field.resize(size_t(glyph.size.x) * glyph.size.y);
+        for (int y = 0; y < glyph.size.y; y++)
+            for (int x = 0; x < glyph.size.x; x++)
+            {
+                const size_t index = size_t(y * UPSAMPLE + UPSAMPLE / 2) * w + x * UPSAMPLE + UPSAMPLE / 2;
+                const float distance = toInside[index] > 0.0f ? 0.5f - std::sqrt(toInside[index]) : std::sqrt(toOutside[index]) - 0.5f;
+                const float value = 0.5f + distance / float(UPSAMPLE * 2 * margin);
+                field[y * glyph.size.x + x] = static_cast<unsigned char>(std::min(std::max(value, 0.0f), 1.0f) * 255.0f + 0.5f);
+            }
+    }
+
+    // squared distance to the nearest zero, for a grid of zeros and FARs (Felzenszwalb & Huttenlocher): the 2D
+    // transform is a 1D transform of every column followed by one of every row
+    static constexpr float FAR = 1e20f;
+
+    static void distanceTransform(std::vector<float> &grid, int w, int h)
+    {
+        const int n = std::max(w, h);
+        std::vector<float> f(n), d(n), z(n + 1);
+        std::vector<int> v(n);
+        for (int x = 0; x < w; x++)
+        {
+            for (int y = 0; y < h; y++)
+                f[y] = grid[size_t(y) * w + x];
+            distanceTransform(f.data(), h, d.data(), v.data(), z.data());
+            for (int y = 0; y < h; y++)
+                grid[size_t(y) * w + x] = d[y];
+        }
+        for (int y = 0; y < h; y++)
+        {
+            distanceTransform(&grid[size_t(y) * w], w, d.data(), v.data(), z.data());
+            std::copy(d.begin(), d.begin() + w, grid.begin() + size_t(y) * w);
+        }
+    }
+
+    // the lower envelope of the parabolas (q - p)^2 + f(p), sampled at every q
+    static void distanceTransform(const float *f, int n, float *d, int *v, float *z)
+    {
+        int k = 0;
+        v[0] = 0;
+        z[0] = -FAR;
+        z[1] = FAR;
+        for (int q = 1; q < n; q++)
+        {
+            float s = ((f[q] + float(q) * q) - (f[v[k]] + float(v[k]) * v[k])) / float(2 * q - 2 * v[k]);
+            while (s <= z[k])
+            {
+                k--;
+                s = ((f[q] + float(q) * q) - (f[v[k]] + float(v[k]) * v[k])) / float(2 * q - 2 * v[k]);
+            }
+            k++;
+            v[k] = q;
+            z[k] = s;
+            z[k + 1] = FAR;
+        }
+        k = 0;
+        for (int q = 0; q < n; q++)
+        {
+            while (z[k + 1] < float(q))
+                k++;
+            d[q] = float(q - v[k]) * float(q - v[k]) + f[v[k]];
+        }
+    }
+
+    // the distance field cache: a header, the glyphs and the atlas pixels
+    struct CacheHeader
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t pixelSize;
+        uint32_t glyphSize;
+        int32_t  width, height;
+        int32_t  capHeight;
+        uint32_t upsample;
+        uint64_t fontHash;
+    };
+    static const uint32_t CACHE_MAGIC = 0x4644534C; // "LSDF"
+    static const uint32_t CACHE_VERSION = 1;
+
+    static bool cacheEnabled()
+    {
+        return getenv("LOGL_NO_GLYPH_CACHE") == nullptr;
+    }
+
+    static bool readFile(const std::string &path, std::vector<char> &contents)
+    {
+        std::ifstream file(path, std::ios::binary);
+        if (!file)
+            return false;
+        contents.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        return true;
+    }
+
+    // 64-bit FNV-1a over the font file
+    static uint64_t hash(const std::vector<char> &contents)
+    {
+        uint64_t value = 0xcbf29ce484222325ULL;
+        for (char c : contents)
+        {
+            value ^= static_cast<unsigned char>(c);
+            value *= 0x100000001b3ULL;
+        }
+        return value;
+    }
+
+    bool readCache(const std::string &font)
+    {
+        std::vector<char> cache, source;
+        if (!readFile(font + ".sdfcache", cache) || cache.size() < sizeof(CacheHeader) || !readFile(font, source))
+            return false;
+        CacheHeader header;
+        memcpy(&header, cache.data(), sizeof(header));
+        if (header.magic != CACHE_MAGIC || header.version != CACHE_VERSION || header.pixelSize != rasterSize ||
+            header.glyphSize != sizeof(Glyph) || header.upsample != UPSAMPLE || header.fontHash != hash(source))
+            return false;
+        if (cache.size() != sizeof(CacheHeader) + sizeof(glyphs) + size_t(header.width) * header.height)
+            return false;
+        width = header.width;
+        height = header.height;
+        cap = header.capHeight;
+        memcpy(glyphs, cache.data() + sizeof(CacheHeader), sizeof(glyphs));
+        pixels.assign(cache.begin() + sizeof(CacheHeader) + sizeof(glyphs), cache.end());
+        return true;
+    }
+
+    // through a temporary file, so a reader never sees a partial cache
+    void writeCache(const std::string &font)
+    {
+        std::vector<char> source;
+        if (!readFile(font, source))
+            return;
+        const std::string path = font + ".sdfcache", tmpPath = path + ".tmp";
+        std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+        CacheHeader header = { CACHE_MAGIC, CACHE_VERSION, rasterSize, uint32_t(sizeof(Glyph)), width, height, cap, uint32_t(UPSAMPLE), hash(source) };
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(glyphs), sizeof(glyphs));
+        out.write(reinterpret_cast<const char*>(pixels.data()), pixels.size());
+        out.close();
+        if (!out || std::rename(tmpPath.c_str(), path.c_str()) != 0)
+        {
+            std::remove(tmpPath.c_str());
+            std::cout << "WARNING::GLYPH_ATLAS:: cannot write " << path << std::endl;
+        }
+    }
+
+    // packs the glyphs, tallest first, into the smallest atlas they fit in, growing the shorter side until they do
+    void pack(const std::vector<std::vector<unsigned char>> &bitmaps)
+    {
+        std::vector<unsigned int> order;
+        int area = 0;
+        for (unsigned int c = 0; c < GLYPH_COUNT; c++)
+            if (glyphs[c].size.x > 0 && glyphs[c].size.y > 0)
+            {
+                order.push_back(c);
+                area += (glyphs[c].size.x + PADDING) * (glyphs[c].size.y + PADDING);
+            }
+        std::stable_sort(order.begin(), order.end(), [this](unsigned int a, unsigned int b) { return glyphs[a].size.y > glyphs[b].size.y; });
+
+        width = height = 64;
+        while (width * height < area)
+            (width <= height ? width : height) *= 2;
+        std::vector<glm::ivec2> positions(GLYPH_COUNT);
+        while (true)
+        {
+            SkylinePacker packer(width, height);
+            bool fits = true;
+            for (size_t i = 0; i < order.size() && fits; i++)
+            {
+                // padding on the left and top here, on the right and bottom from the atlas edge or the next glyph
+                fits = packer.insert(glyphs[order[i]].size.x + PADDING, glyphs[order[i]].size.y + PADDING, positions[order[i]]);
+                positions[order[i]] += PADDING;
+            }
+            if (fits)
+                break;
+            (width <= height ? width : height) *= 2;
+        }
+
+        pixels.assign(width * height, 0);
+        for (unsigned int c : order)
+        {
+            Glyph &glyph = glyphs[c];
+            for (int row = 0; row < glyph.size.y; row++)
+                memcpy(&pixels[(positions[c].y + row) * width + positions[c].x], &bitmaps[c][row * glyph.size.x], glyph.size.x);
+            glyph.uvMin = glm::vec2(positions[c]) / glm::vec2(width, height);
+            glyph.uvMax = glm::vec2(positions[c] + glyph.size) / glm::vec2(width, height);
+        }
+    }
+
+    void upload()
+    {
+        if (!id)
+            glGenTextures(1, &id);
+        glBindTexture(GL_TEXTURE_2D, id);
+        // rows of a red-only texture aren't 4 byte aligned
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, width, height, 0, GL_RED, GL_UNSIGNED_BYTE, pixels.data());
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+
+    Glyph glyphs[GLYPH_COUNT] = {};
+    std::vector<unsigned char> pixels;
+    int width = 0, height = 0;
+    int cap = 0;
+    unsigned int rasterSize = 0;
+    GlyphMode glyphMode = GlyphMode::BITMAP;
+    unsigned int id = 0;
+};
+#endif
@@ -6,29 +6,19 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
+#include <learnopengl/mesh_simplifier.h>
 #include <learnopengl/shader.h>
+#include <learnopengl/vertex_format.h>
 
 #include <string>
 #include <vector>
 using namespace std;
 
-#define MAX_BONE_INFLUENCE 4
-
-struct Vertex {
-    // position
-    glm::vec3 Position;
-    // normal
-    glm::vec3 Normal;
-    // texCoords
-    glm::vec2 TexCoords;
-    // tangent
-    glm::vec3 Tangent;
-    // bitangent
-    glm::vec3 Bitangent;
-	//bone indexes which will influence this vertex
-	int m_BoneIDs[MAX_BONE_INFLUENCE];
-	//weights from each bone
-	float m_Weights[MAX_BONE_INFLUENCE];
+// a range of the index buffer drawing the mesh at one level of detail
+struct MeshLod {
+    unsigned int first;
+    unsigned int count;
+    float error;        // how far the surface moved from the full mesh, see MeshSimplifier::simplify
 };
 
 struct Texture {
@@ -44,79 +34,172 @@ public:
     vector<unsigned int> indices;
     vector<Texture>      textures;
     unsigned int VAO;
+    VertexLayout layout = VertexLayout::FULL; // what the vertex buffer holds, see setupMesh
+    GLenum indexType = GL_UNSIGNED_INT;       // GL_UNSIGNED_SHORT for meshes of at most 65536 vertices
+    vector<MeshLod> lods;                     // lods[0] is the full mesh, simpler ones follow after setLevels
 
-    // constructor
-    Mesh(vector<Vertex> vertices, vector<unsigned int> indices, vector<Texture> textures)
+    // constructor; compact uploads the vertices as StaticVertex or SkinnedVertex, for shaders that decode them
+    Mesh(vector<Vertex> vertices, vector<unsigned int> indices, vector<Texture> textures, bool compact = false)
     {
-        this->vertices = vertices;
-        this->indices = indices;
-        this->textures = textures;
+        this->vertices = std::move(vertices);
+        this->indices = std::move(indices);
+        this->textures = std::move(textures);
+        this->compact = compact;
 
         // now that we have all the required data, set the vertex buffers and its attribute pointers.
         setupMesh();
     }
 
+    // constructor from raw arrays, e.g. a memory mapped mesh cache; the data is copied once.
+    Mesh(const Vertex *vertices, size_t numVertices, const unsigned int *indices, size_t numIndices, vector<Texture> textures, bool compact = false)
+        : vertices(vertices, vertices + numVertices), indices(indices, indices + numIndices), textures(std::move(textures)), compact(compact)
+    {
+        setupMesh();
+    }
+
     // render the mesh
     void Draw(Shader &shader) 
     {
         // bind appropriate textures
-        unsigned int diffuseNr  = 1;
-        unsigned int specularNr = 1;
-        unsigned int normalNr   = 1;
-        unsigned int heightNr   = 1;
+        if(samplerNames.size() != textures.size())
+            setupSamplerNames();
         for(unsigned int i = 0; i < textures.size(); i++)
         {
             glActiveTexture(GL_TEXTURE0 + i); // active proper texture unit before binding
-            // retrieve texture number (the N in diffuse_textureN)
-            string number;
-            string name = textures[i].type;
-            if(name == "texture_diffuse")
-                number = std::to_string(diffuseNr++);
-            else if(name == "texture_specular")
-                number = std::to_string(specularNr++); // transfer unsigned int to string
-            else if(name == "texture_normal")
-                number = std::to_string(normalNr++); // transfer unsigned int to string
-             else if(name == "texture_height")
-                number = std::to_string(heightNr++); // transfer unsigned int to string
-
             // now set the sampler to the correct texture unit
-            glUniform1i(glGetUniformLocation(shader.ID, (name + number).c_str()), i);
+            glUniform1i(shader.uniformLocation(samplerNames[i].c_str()), i);
             // and finally bind the texture
             glBindTexture(GL_TEXTURE_2D, textures[i].id);
         }
         
         // draw mesh
         glBindVertexArray(VAO);
-        glDrawElements(GL_TRIANGLES, static_cast<unsigned int>(indices.size()), GL_UNSIGNED_INT, 0);
+        glDrawElements(GL_TRIANGLES, static_cast<unsigned int>(indices.size()), indexType, 0);
         glBindVertexArray(0);
 
         // always good practice to set everything back to defaults once configured.
         glActiveTexture(GL_TEXTURE0);
     }
 
+    // Appends simplified index lists (MeshSimplifier::buildLevels) to the index buffer as lods[1] and up. They use
+    // the same vertices, so drawing a level only changes the index range
+    void setLevels(const vector<MeshSimplifier::Level> &levels)
+    {
+        vector<unsigned int> all(indices);
+        lods.resize(1);
+        for(const MeshSimplifier::Level &level : levels)
+        {
+            lods.push_back({ static_cast<unsigned int>(all.size()), static_cast<unsigned int>(level.indices.size()), level.error });
+            all.insert(all.end(), level.indices.begin(), level.indices.end());
+        }
+        glBindVertexArray(VAO);
+        uploadIndices(all);
+        glBindVertexArray(0);
+    }
+
+    // byte offset of a level in the index buffer, for glDrawElements
+    const void *lodOffset(int lod) const
+    {
+        return (const void*)(size_t(lods[lod].first) * (indexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(unsigned int)));
+    }
+
+    // bytes in the vertex buffer
+    size_t vertexBufferSize() const
+    {
+        return vertices.size() * vertexStride(layout);
+    }
+
 private:
     // render data 
     unsigned int VBO, EBO;
+    bool compact = false;
+    vector<string> samplerNames; // the sampler each texture binds to, e.g. texture_diffuse2
+
+    // names the samplers after the texture type plus a per type counter (the N in texture_diffuseN)
+    void setupSamplerNames()
+    {
+        unsigned int diffuseNr  = 1;
+        unsigned int specularNr = 1;
+        unsigned int normalNr   = 1;
+        unsigned int heightNr   = 1;
+        samplerNames.clear();
+        for(unsigned int i = 0; i < textures.size(); i++)
+        {
+            string number;
+            string name = textures[i].type;
+            if(name == "texture_diffuse")
+                number = std::to_string(diffuseNr++);
+            else if(name == "texture_specular")
+                number = std::to_string(specularNr++); // transfer unsigned int to string
+            else if(name == "texture_normal")
+                number = std::to_string(normalNr++); // transfer unsigned int to string
+             else if(name == "texture_height")
+                number = std::to_string(heightNr++); // transfer unsigned int to string
+            samplerNames.push_back(name + number);
+        }
+    }
 
     // initializes all the buffer objects/arrays
     void setupMesh()
     {
+        setupSamplerNames();
+
         // create buffers/arrays
         glGenVertexArrays(1, &VAO);
         glGenBuffers(1, &VBO);
         glGenBuffers(1, &EBO);
 
         glBindVertexArray(VAO);
+        // a compact mesh is skinned if any vertex has a bone; ids past a byte keep the full layout
+        if(compact)
+        {
+            layout = VertexLayout::STATIC;
+            for(const Vertex &vertex : vertices)
+            {
+                if(!VertexPacking::fitsSkinned(vertex))
+                {
+                    layout = VertexLayout::FULL;
+                    break;
+                }
+                if(VertexPacking::isSkinned(vertex))
+                    layout = VertexLayout::SKINNED;
+            }
+        }
         // load data into vertex buffers
         glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        if(layout == VertexLayout::STATIC)
+            setupStaticAttributes();
+        else if(layout == VertexLayout::SKINNED)
+            setupSkinnedAttributes();
+        else
+            setupFullAttributes();
+
+        lods.assign(1, MeshLod{ 0, static_cast<unsigned int>(indices.size()), 0.0f });
+        uploadIndices(indices);
+        glBindVertexArray(0);
+    }
+
+    // into the EBO of the bound VAO; indices of small meshes fit in 16 bits, which halves the index buffer
+    void uploadIndices(const vector<unsigned int> &all)
+    {
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+        if(vertices.size() <= 65536)
+        {
+            indexType = GL_UNSIGNED_SHORT;
+            vector<uint16_t> shortIndices(all.begin(), all.end());
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, shortIndices.size() * sizeof(uint16_t), shortIndices.data(), GL_STATIC_DRAW);
+        }
+        else
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, all.size() * sizeof(unsigned int), all.data(), GL_STATIC_DRAW);
+    }
+
+    void setupFullAttributes()
+    {
         // A great thing about structs is that their memory layout is sequential for all its items.
         // The effect is that we can simply pass a pointer to the struct and it translates perfectly to a glm::vec3/2 array which
         // again translates to 3/2 floats which translates to a byte array.
         glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);  
 
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
-
         // set the vertex attribute pointers
         // vertex Positions
         glEnableVertexAttribArray(0);	
@@ -140,7 +223,41 @@ private:
 		// weights
 		glEnableVertexAttribArray(6);
 		glVertexAttribPointer(6, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, m_Weights));
-        glBindVertexArray(0);
+    }
+
+    // position, packed tangent frame and half float texture coords; locations 3 and 4 stay free
+    template <typename Packed>
+    void setupCompactAttributes()
+    {
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Packed), (void*)offsetof(Packed, Position));
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 4, GL_SHORT, GL_TRUE, sizeof(Packed), (void*)offsetof(Packed, Frame));
+        glEnableVertexAttribArray(2);
+        glVertexAttribPointer(2, 2, GL_HALF_FLOAT, GL_FALSE, sizeof(Packed), (void*)offsetof(Packed, TexCoords));
+    }
+
+    void setupStaticAttributes()
+    {
+        vector<StaticVertex> packed(vertices.size());
+        for(size_t i = 0; i < vertices.size(); i++)
+            packed[i] = VertexPacking::packStatic(vertices[i]);
+        glBufferData(GL_ARRAY_BUFFER, packed.size() * sizeof(StaticVertex), packed.data(), GL_STATIC_DRAW);
+        setupCompactAttributes<StaticVertex>();
+    }
+
+    void setupSkinnedAttributes()
+    {
+        vector<SkinnedVertex> packed(vertices.size());
+        for(size_t i = 0; i < vertices.size(); i++)
+            packed[i] = VertexPacking::packSkinned(vertices[i]);
+        glBufferData(GL_ARRAY_BUFFER, packed.size() * sizeof(SkinnedVertex), packed.data(), GL_STATIC_DRAW);
+        setupCompactAttributes<SkinnedVertex>();
+        // bone ids as integers, weights normalized to [0, 1]
+        glEnableVertexAttribArray(5);
+        glVertexAttribIPointer(5, 4, GL_UNSIGNED_BYTE, sizeof(SkinnedVertex), (void*)offsetof(SkinnedVertex, BoneIDs));
+        glEnableVertexAttribArray(6);
+        glVertexAttribPointer(6, 4, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(SkinnedVertex), (void*)offsetof(SkinnedVertex, Weights));
     }
 };
 #endif
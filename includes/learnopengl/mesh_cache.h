@@ -0,0 +1,265 @@
+#ifndef MESH_CACHE_H
+#define MESH_CACHE_H
+
+#include <learnopengl/mesh.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <iostream>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// On-disk cache of the processed vertex/index/texture-path arrays that Model builds from Assimp.
+// The cache lives next to the source file as "<source>.meshcache" and is only accepted if its
+// version, the hash of the source file (and of a .obj's mtllib files) and the Assimp post-process
+// flags all match. Textures are stored by path only, so editing an image itself needs no rebuild.
+// Set LOGL_NO_MESH_CACHE in the environment to always go through Assimp.
+namespace MeshCache
+{
+    const uint32_t MAGIC   = 0x48534D4C; // "LMSH"
+    const uint32_t VERSION = 2; // 2: meshes are stored optimized (MeshOptimizer)
+
+    struct FileHeader
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t importFlags;
+        uint32_t meshCount;
+        uint64_t sourceHash;
+    };
+
+    // followed by vertexCount Vertex structs, indexCount indices and textureCount texture records
+    struct MeshHeader
+    {
+        uint32_t vertexCount;
+        uint32_t indexCount;
+        uint32_t textureCount;
+        uint32_t vertexSize;
+    };
+
+    // a read-only view of a whole file; mmap'ed where available, read into memory otherwise
+    class MappedFile
+    {
+    public:
+        const char* data = nullptr;
+        size_t size = 0;
+
+        explicit MappedFile(const std::string& path)
+        {
+#ifndef _WIN32
+            int fd = open(path.c_str(), O_RDONLY);
+            if (fd < 0)
+                return;
+            struct stat st;
+            if (fstat(fd, &st) == 0 && st.st_size > 0)
+            {
+                void* p = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (p != MAP_FAILED)
+                {
+                    data = static_cast<const char*>(p);
+                    size = st.st_size;
+                }
+            }
+            close(fd);
+#else
+            std::ifstream file(path, std::ios::binary | std::ios::ate);
+            if (!file)
+                return;
+            buffer.resize(static_cast<size_t>(file.tellg()));
+            file.seekg(0);
+            file.read(buffer.data(), buffer.size());
+            data = buffer.data();
+            size = buffer.size();
+#endif
+        }
+        ~MappedFile()
+        {
+#ifndef _WIN32
+            if (data)
+                munmap(const_cast<char*>(data), size);
+#endif
+        }
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+    private:
+#ifdef _WIN32
+        std::vector<char> buffer;
+#endif
+    };
+
+    inline bool enabled()
+    {
+        return getenv("LOGL_NO_MESH_CACHE") == nullptr;
+    }
+
+    inline std::string cachePath(const std::string& sourcePath)
+    {
+        return sourcePath + ".meshcache";
+    }
+
+    // 64-bit FNV-1a, continued from hash
+    inline uint64_t hashBytes(const char* data, size_t size, uint64_t hash = 0xcbf29ce484222325ULL)
+    {
+        for (size_t i = 0; i < size; i++)
+        {
+            hash ^= static_cast<unsigned char>(data[i]);
+            hash *= 0x100000001b3ULL;
+        }
+        return hash;
+    }
+
+    // hash of the source file contents; for a .obj the material libraries it names with mtllib are folded in
+    // too, since the texture records come from those
+    inline uint64_t hashFile(const std::string& path)
+    {
+        MappedFile file(path);
+        uint64_t hash = hashBytes(file.data, file.size);
+        if (path.size() < 4 || path.compare(path.size() - 4, 4, ".obj") != 0)
+            return hash;
+
+        const std::string directory = path.substr(0, path.find_last_of("/\\") + 1);
+        const char* end = file.data + file.size;
+        for (const char* line = file.data; line < end; )
+        {
+            const char* lineEnd = static_cast<const char*>(memchr(line, '\n', end - line));
+            if (!lineEnd)
+                lineEnd = end;
+            // like Assimp, the rest of the line is one file name
+            if (lineEnd - line > 7 && memcmp(line, "mtllib", 6) == 0 && (line[6] == ' ' || line[6] == '\t'))
+            {
+                const char* first = line + 7;
+                const char* last = lineEnd;
+                while (first < last && (*first == ' ' || *first == '\t'))
+                    first++;
+                while (last > first && (last[-1] == ' ' || last[-1] == '\t' || last[-1] == '\r'))
+                    last--;
+                // the name goes in as well, so a library that is missing or goes missing still changes the hash
+                hash = hashBytes(first, last - first, hash);
+                MappedFile library(directory + std::string(first, last));
+                hash = hashBytes(library.data, library.size, hash);
+            }
+            line = lineEnd + 1;
+        }
+        return hash;
+    }
+
+    inline size_t padded(size_t n)
+    {
+        return (n + 3) & ~size_t(3);
+    }
+
+    // calls onMesh(const Vertex*, vertexCount, const unsigned int*, indexCount, vector<Texture>) for every cached mesh,
+    // with Texture::id left unset. Returns false (without calling onMesh) if there is no valid cache for this source.
+    template<typename OnMesh>
+    bool read(const std::string& sourcePath, unsigned int importFlags, OnMesh onMesh)
+    {
+        MappedFile file(cachePath(sourcePath));
+        if (!file.data || file.size < sizeof(FileHeader))
+            return false;
+
+        FileHeader header;
+        memcpy(&header, file.data, sizeof(header));
+        if (header.magic != MAGIC || header.version != VERSION || header.importFlags != importFlags)
+            return false;
+        if (header.sourceHash != hashFile(sourcePath))
+            return false;
+
+        // validate the whole file before handing out any mesh so a truncated cache falls back cleanly
+        const char* end = file.data + file.size;
+        const char* cursor = file.data + sizeof(FileHeader);
+        for (int pass = 0; pass < 2; pass++)
+        {
+            cursor = file.data + sizeof(FileHeader);
+            for (uint32_t m = 0; m < header.meshCount; m++)
+            {
+                if (cursor + sizeof(MeshHeader) > end)
+                    return false;
+                MeshHeader mesh;
+                memcpy(&mesh, cursor, sizeof(mesh));
+                cursor += sizeof(MeshHeader);
+                if (mesh.vertexSize != sizeof(Vertex))
+                    return false;
+
+                const Vertex* vertices = reinterpret_cast<const Vertex*>(cursor);
+                cursor += size_t(mesh.vertexCount) * sizeof(Vertex);
+                const unsigned int* indices = reinterpret_cast<const unsigned int*>(cursor);
+                cursor += size_t(mesh.indexCount) * sizeof(unsigned int);
+                if (cursor > end)
+                    return false;
+
+                vector<Texture> textures(mesh.textureCount);
+                for (uint32_t t = 0; t < mesh.textureCount; t++)
+                {
+                    uint32_t lengths[2];
+                    if (cursor + sizeof(lengths) > end)
+                        return false;
+                    memcpy(lengths, cursor, sizeof(lengths));
+                    cursor += sizeof(lengths);
+                    if (cursor + padded(lengths[0]) + padded(lengths[1]) > end)
+                        return false;
+                    textures[t].type.assign(cursor, lengths[0]);
+                    cursor += padded(lengths[0]);
+                    textures[t].path.assign(cursor, lengths[1]);
+                    cursor += padded(lengths[1]);
+                }
+                if (pass == 1)
+                    onMesh(vertices, mesh.vertexCount, indices, mesh.indexCount, std::move(textures));
+            }
+        }
+        return true;
+    }
+
+    // writes the meshes to "<source>.meshcache" through a temporary file so readers never see a partial cache
+    inline bool write(const std::string& sourcePath, unsigned int importFlags, const vector<Mesh>& meshes)
+    {
+        std::string path = cachePath(sourcePath);
+        std::string tmpPath = path + ".tmp";
+        std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+        if (!out)
+        {
+            std::cout << "WARNING::MESH_CACHE:: cannot write " << path << std::endl;
+            return false;
+        }
+
+        FileHeader header = { MAGIC, VERSION, importFlags, static_cast<uint32_t>(meshes.size()), hashFile(sourcePath) };
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+        const char zeros[4] = { 0, 0, 0, 0 };
+        for (const Mesh& mesh : meshes)
+        {
+            MeshHeader meshHeader = { static_cast<uint32_t>(mesh.vertices.size()), static_cast<uint32_t>(mesh.indices.size()),
+                                      static_cast<uint32_t>(mesh.textures.size()), static_cast<uint32_t>(sizeof(Vertex)) };
+            out.write(reinterpret_cast<const char*>(&meshHeader), sizeof(meshHeader));
+            out.write(reinterpret_cast<const char*>(mesh.vertices.data()), mesh.vertices.size() * sizeof(Vertex));
+            out.write(reinterpret_cast<const char*>(mesh.indices.data()), mesh.indices.size() * sizeof(unsigned int));
+            for (const Texture& texture : mesh.textures)
+            {
+                uint32_t lengths[2] = { static_cast<uint32_t>(texture.type.size()), static_cast<uint32_t>(texture.path.size()) };
+                out.write(reinterpret_cast<const char*>(lengths), sizeof(lengths));
+                out.write(texture.type.data(), texture.type.size());
+                out.write(zeros, padded(texture.type.size()) - texture.type.size());
+                out.write(texture.path.data(), texture.path.size());
+                out.write(zeros, padded(texture.path.size()) - texture.path.size());
+            }
+        }
+        out.close();
+        if (!out || std::rename(tmpPath.c_str(), path.c_str()) != 0)
+        {
+            std::remove(tmpPath.c_str());
+            std::cout << "WARNING::MESH_CACHE:: cannot write " << path << std::endl;
+            return false;
+        }
+        return true;
+    }
+}
+#endif
@@ -0,0 +1,276 @@
+#ifndef MESH_OPTIMIZER_H
+#define MESH_OPTIMIZER_H
+
+#include <glm/glm.hpp>
+
+#include <learnopengl/vertex_format.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+// Import-time reordering of triangle lists for the GPU:
+// - optimizeVertexCache orders the triangles so vertices are reused while they are still in the post-transform cache
+//   (Tom Forsyth's "Linear-Speed Vertex Cache Optimisation"),
+// - optimizeOverdraw optionally reorders whole clusters of that order so triangles facing out of the mesh come first,
+// - optimizeVertexFetch then stores the vertices in the order the triangles first use them, so fetches stream.
+// None of them changes what is drawn, only the order. analyzeVertexCache measures the result on a FIFO cache.
+// Set LOGL_MESH_OVERDRAW in the environment to also run optimizeOverdraw on import and LOGL_MESH_STATS to print the
+// cache statistics of every imported model. Meshes read from a mesh cache keep the order they were cached with.
+namespace MeshOptimizer
+{
+    inline bool overdrawEnabled()
+    {
+        return getenv("LOGL_MESH_OVERDRAW") != nullptr;
+    }
+
+    inline bool statsEnabled()
+    {
+        return getenv("LOGL_MESH_STATS") != nullptr;
+    }
+
+    struct CacheStats
+    {
+        float acmr = 0.0f; // average cache miss ratio: vertices transformed per triangle, 0.5 at best, 3 at worst
+        float atvr = 0.0f; // average transform to vertex ratio: vertices transformed per vertex used, 1 at best
+    };
+
+    // simulates a FIFO post-transform cache of cacheSize entries
+    inline CacheStats analyzeVertexCache(const std::vector<unsigned int> &indices, size_t vertexCount, unsigned int cacheSize = 16)
+    {
+        CacheStats stats;
+        if(indices.empty())
+            return stats;
+        // a vertex is in the cache while less than cacheSize misses happened since it was last loaded
+        std::vector<size_t> loadedAt(vertexCount, 0);
+        std::vector<bool> used(vertexCount, false);
+        size_t misses = 0, unique = 0;
+        for(unsigned int index : indices)
+        {
+            if(!used[index])
+            {
+                used[index] = true;
+                unique++;
+            }
+            else if(misses - loadedAt[index] < cacheSize)
+                continue;
+            misses++;
+            loadedAt[index] = misses;
+        }
+        stats.acmr = float(misses) / float(indices.size() / 3);
+        stats.atvr = float(misses) / float(unique);
+        return stats;
+    }
+
+    // Greedy: always emits the triangle whose vertices score best, where a vertex scores for being recently used (still
+    // in the simulated LRU cache) and for having few triangles left (so the last ones aren't left behind as stragglers)
+    inline void optimizeVertexCache(std::vector<unsigned int> &indices, size_t vertexCount)
+    {
+        const int CACHE_SIZE = 32;
+        const size_t triangleCount = indices.size() / 3;
+        if(triangleCount == 0)
+            return;
+
+        // triangles of every vertex, as one array with offsets
+        std::vector<unsigned int> offsets(vertexCount + 1, 0), remaining(vertexCount, 0);
+        for(unsigned int index : indices)
+            offsets[index + 1]++;
+        for(size_t v = 0; v < vertexCount; v++)
+        {
+            remaining[v] = offsets[v + 1];
+            offsets[v + 1] += offsets[v];
+        }
+        std::vector<unsigned int> triangles(indices.size()), filled(offsets.begin(), offsets.end() - 1);
+        for(size_t t = 0; t < triangleCount; t++)
+            for(int k = 0; k < 3; k++)
+                triangles[filled[indices[t * 3 + k]]++] = static_cast<unsigned int>(t);
+
+        auto vertexScore = [](int cachePosition, unsigned int valence)
+        {
+            if(valence == 0)
+                return -1.0f; // nothing left to draw with it
+            float score = 0.0f;
+            if(cachePosition >= 0)
+                score = cachePosition < 3 ? 0.75f // used by the last triangle: deliberately not the best, to avoid strips
+                                          : std::pow(1.0f - float(cachePosition - 3) / float(CACHE_SIZE - 3), 1.5f);
+            return score + 2.0f / std::sqrt(float(valence));
+        };
+
+        std::vector<int> cachePosition(vertexCount, -1);
+        std::vector<float> score(vertexCount), triangleScore(triangleCount);
+        std::vector<bool> emitted(triangleCount, false);
+        for(size_t v = 0; v < vertexCount; v++)
+            score[v] = vertexScore(-1, remaining[v]);
+        for(size_t t = 0; t < triangleCount; t++)
+            triangleScore[t] = score[indices[t * 3]] + score[indices[t * 3 + 1]] + score[indices[t * 3 + 2]];
+
+        std::vector<unsigned int> out;
+        out.reserve(indices.size());
+        std::vector<unsigned int> cache, nextCache;
+        cache.reserve(CACHE_SIZE + 3);
+        nextCache.reserve(CACHE_SIZE + 3);
+        size_t best = 0, scan = 0;
+        while(true)
+        {
+            emitted[best] = true;
+            const unsigned int *triangle = &indices[best * 3];
+            // the triangle's vertices move to the front of the cache, the others move back
+            nextCache.assign(triangle, triangle + 3);
+            for(unsigned int v : cache)
+                if(v != triangle[0] && v != triangle[1] && v != triangle[2])
+                    nextCache.push_back(v);
+            for(int k = 0; k < 3; k++)
+            {
+                out.push_back(triangle[k]);
+                // drop the triangle from the vertex's list of triangles still to draw
+                unsigned int *begin = &triangles[offsets[triangle[k]]], *end = begin + remaining[triangle[k]];
+                *std::find(begin, end, static_cast<unsigned int>(best)) = *(end - 1);
+                remaining[triangle[k]]--;
+            }
+
+            // rescore what is in the cache (and what just fell out) and their triangles; the best of those goes next
+            float bestScore = -1.0f;
+            for(size_t i = 0; i < nextCache.size(); i++)
+            {
+                const unsigned int v = nextCache[i];
+                const int position = i < size_t(CACHE_SIZE) ? int(i) : -1;
+                cachePosition[v] = position;
+                const float delta = vertexScore(position, remaining[v]) - score[v];
+                score[v] += delta;
+                for(unsigned int j = 0; j < remaining[v]; j++)
+                {
+                    const unsigned int t = triangles[offsets[v] + j];
+                    triangleScore[t] += delta;
+                    if(triangleScore[t] > bestScore)
+                    {
+                        bestScore = triangleScore[t];
+                        best = t;
+                    }
+                }
+            }
+            if(nextCache.size() > size_t(CACHE_SIZE))
+                nextCache.resize(CACHE_SIZE);
+            cache.swap(nextCache);
+
+            // nothing left around the cache: continue with the best remaining triangle of the whole mesh. Scores only
+            // drift while vertices are near the cache, so the first triangle not emitted yet is a good enough choice
+            if(bestScore < 0.0f)
+            {
+                while(scan < triangleCount && emitted[scan])
+                    scan++;
+                if(scan == triangleCount)
+                    break;
+                best = scan;
+            }
+        }
+        indices.swap(out);
+    }
+
+    // Splits the cache optimized order into clusters and sorts them front to back as seen from outside: clusters whose
+    // normal points away from the mesh center come first, so they occlude the ones behind them. After sorting, every
+    // cluster starts on a cold cache, so a cluster only ends once its ACMR from a cold start is within threshold
+    // times the ACMR of the whole mesh: that bounds what the reordering costs the vertex cache.
+    inline void optimizeOverdraw(std::vector<unsigned int> &indices, const std::vector<Vertex> &vertices, float threshold = 1.05f, unsigned int cacheSize = 16)
+    {
+        const size_t triangleCount = indices.size() / 3;
+        if(triangleCount == 0)
+            return;
+        const float limit = analyzeVertexCache(indices, vertices.size(), cacheSize).acmr * threshold;
+
+        // a vertex is in the cache if it was loaded within the current cluster and less than cacheSize misses ago
+        std::vector<size_t> clusterStart(1, 0);
+        std::vector<size_t> loadedAt(vertices.size(), 0);
+        size_t misses = 0, clusterFirstMiss = 0;
+        for(size_t t = 0; t < triangleCount; t++)
+        {
+            for(int k = 0; k < 3; k++)
+            {
+                const unsigned int index = indices[t * 3 + k];
+                if(loadedAt[index] > clusterFirstMiss && misses - loadedAt[index] < cacheSize)
+                    continue;
+                misses++;
+                loadedAt[index] = misses;
+            }
+            const size_t length = t + 1 - clusterStart.back();
+            if(t + 1 < triangleCount && float(misses - clusterFirstMiss) <= limit * float(length))
+            {
+                clusterStart.push_back(t + 1);
+                clusterFirstMiss = misses;
+            }
+        }
+        clusterStart.push_back(triangleCount);
+
+        glm::vec3 meshCenter(0.0f);
+        for(const Vertex &vertex : vertices)
+            meshCenter += vertex.Position;
+        meshCenter /= float(std::max<size_t>(vertices.size(), 1));
+
+        // area weighted center and normal of every cluster
+        const size_t clusterCount = clusterStart.size() - 1;
+        std::vector<float> key(clusterCount);
+        for(size_t c = 0; c < clusterCount; c++)
+        {
+            glm::vec3 center(0.0f), normal(0.0f);
+            float area = 0.0f;
+            for(size_t t = clusterStart[c]; t < clusterStart[c + 1]; t++)
+            {
+                const glm::vec3 &a = vertices[indices[t * 3]].Position, &b = vertices[indices[t * 3 + 1]].Position, &c2 = vertices[indices[t * 3 + 2]].Position;
+                const glm::vec3 cross = glm::cross(b - a, c2 - a);
+                const float triangleArea = glm::length(cross);
+                center += (a + b + c2) * (triangleArea / 3.0f);
+                normal += cross;
+                area += triangleArea;
+            }
+            const float normalLength = glm::length(normal);
+            key[c] = area > 0.0f && normalLength > 0.0f ? glm::dot(center / area - meshCenter, normal / normalLength) : 0.0f;
+        }
+
+        std::vector<size_t> order(clusterCount);
+        for(size_t c = 0; c < clusterCount; c++)
+            order[c] = c;
+        std::stable_sort(order.begin(), order.end(), [&key](size_t a, size_t b) { return key[a] > key[b]; });
+        std::vector<unsigned int> out;
+        out.reserve(indices.size());
+        for(size_t c : order)
+            out.insert(out.end(), indices.begin() + clusterStart[c] * 3, indices.begin() + clusterStart[c + 1] * 3);
+        indices.swap(out);
+    }
+
+    // Renumbers the vertices in the order the indices first reference them; vertices no triangle uses go last
+    inline void optimizeVertexFetch(std::vector<Vertex> &vertices, std::vector<unsigned int> &indices)
+    {
+        const unsigned int UNUSED = ~0u;
+        std::vector<unsigned int> remap(vertices.size(), UNUSED);
+        std::vector<Vertex> out;
+        out.reserve(vertices.size());
+        for(unsigned int &index : indices)
+        {
+            if(remap[index] == UNUSED)
+            {
+                remap[index] = static_cast<unsigned int>(out.size());
+                out.push_back(vertices[index]);
+            }
+            index = remap[index];
+        }
+        for(size_t v = 0; v < vertices.size(); v++)
+            if(remap[v] == UNUSED)
+                out.push_back(vertices[v]);
+        vertices.swap(out);
+    }
+
+    // all of the above in order, returning the cache statistics before and after
+    inline void optimize(std::vector<Vertex> &vertices, std::vector<unsigned int> &indices, bool overdraw, CacheStats *before = nullptr, CacheStats *after = nullptr)
+    {
+        if(before)
+            *before = analyzeVertexCache(indices, vertices.size());
+        optimizeVertexCache(indices, vertices.size());
+        if(overdraw)
+            optimizeOverdraw(indices, vertices);
+        optimizeVertexFetch(vertices, indices);
+        if(after)
+            *after = analyzeVertexCache(indices, vertices.size());
+    }
+}
+#endif
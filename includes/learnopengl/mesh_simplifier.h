@@ -0,0 +1,272 @@
+#ifndef MESH_SIMPLIFIER_H
+#define MESH_SIMPLIFIER_H
+
+#include <glm/glm.hpp>
+
+#include <learnopengl/mesh_optimizer.h>
+#include <learnopengl/vertex_format.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+// Levels of detail by quadric error edge collapse (Garland & Heckbert). Collapses move a vertex onto one of its
+// neighbours instead of to a new position, so a simplified mesh is only a new index list over the same vertices and
+// every level of detail can share the original vertex buffer. Vertices on open borders and on attribute seams (the
+// same position stored more than once, e.g. with different texture coords) stay where they are, which keeps the
+// silhouette of holes and the texture mapping intact.
+namespace MeshSimplifier
+{
+    // sum of squared distances to a set of planes, weighted by the area of the triangles they come from
+    struct Quadric
+    {
+        double a00 = 0, a01 = 0, a02 = 0, a11 = 0, a12 = 0, a22 = 0, b0 = 0, b1 = 0, b2 = 0, c = 0, weight = 0;
+
+        void addPlane(const glm::dvec3 &normal, double distance, double w)
+        {
+            a00 += w * normal.x * normal.x; a01 += w * normal.x * normal.y; a02 += w * normal.x * normal.z;
+            a11 += w * normal.y * normal.y; a12 += w * normal.y * normal.z; a22 += w * normal.z * normal.z;
+            b0 += w * normal.x * distance; b1 += w * normal.y * distance; b2 += w * normal.z * distance;
+            c += w * distance * distance;
+            weight += w;
+        }
+
+        void add(const Quadric &q)
+        {
+            a00 += q.a00; a01 += q.a01; a02 += q.a02; a11 += q.a11; a12 += q.a12; a22 += q.a22;
+            b0 += q.b0; b1 += q.b1; b2 += q.b2; c += q.c; weight += q.weight;
+        }
+
+        // mean squared distance of p to the planes
+        double error(const glm::vec3 &p) const
+        {
+            const double x = p.x, y = p.y, z = p.z;
+            const double e = a00 * x * x + a11 * y * y + a22 * z * z + 2.0 * (a01 * x * y + a02 * x * z + a12 * y * z)
+                           + 2.0 * (b0 * x + b1 * y + b2 * z) + c;
+            return weight > 0.0 ? std::max(e, 0.0) / weight : 0.0;
+        }
+    };
+
+    // Removes triangles until at most targetIndexCount indices are left or the next collapse would move the surface
+    // further than maxError (in the mesh's units). Returns the new index list; error receives the largest error a
+    // collapse introduced, measured as the root mean squared distance to the original surface around it.
+    inline std::vector<unsigned int> simplify(const std::vector<Vertex> &vertices, const std::vector<unsigned int> &indices,
+                                              size_t targetIndexCount, float maxError, float *error = nullptr)
+    {
+        const size_t vertexCount = vertices.size();
+        std::vector<unsigned int> result(indices);
+        if(error)
+            *error = 0.0f;
+
+        // vertices sharing a position are one point of the surface; canonical is the first of them
+        struct PositionHash
+        {
+            size_t operator()(const glm::vec3 &p) const
+            {
+                unsigned int bits[3];
+                memcpy(bits, &p, sizeof(bits));
+                return (bits[0] * 73856093u) ^ (bits[1] * 19349663u) ^ (bits[2] * 83492791u);
+            }
+        };
+        std::unordered_map<glm::vec3, unsigned int, PositionHash> firstAt;
+        std::vector<unsigned int> canonical(vertexCount);
+        std::vector<bool> locked(vertexCount, false);
+        for(unsigned int v = 0; v < vertexCount; v++)
+        {
+            auto inserted = firstAt.emplace(vertices[v].Position, v);
+            canonical[v] = inserted.first->second;
+            if(!inserted.second)
+                locked[canonical[v]] = true; // a seam
+        }
+
+        // an edge used by a single triangle is on a border
+        std::unordered_map<unsigned long long, int> edgeUses;
+        auto edgeKey = [](unsigned int a, unsigned int b) { return a < b ? (unsigned long long)a << 32 | b : (unsigned long long)b << 32 | a; };
+        for(size_t i = 0; i < result.size(); i += 3)
+            for(int k = 0; k < 3; k++)
+                edgeUses[edgeKey(canonical[result[i + k]], canonical[result[i + (k + 1) % 3]])]++;
+        for(size_t i = 0; i < result.size(); i += 3)
+            for(int k = 0; k < 3; k++)
+                if(edgeUses[edgeKey(canonical[result[i + k]], canonical[result[i + (k + 1) % 3]])] != 2)
+                {
+                    locked[canonical[result[i + k]]] = true;
+                    locked[canonical[result[i + (k + 1) % 3]]] = true;
+                }
+
+        // the planes of the triangles around every point
+        std::vector<Quadric> quadrics(vertexCount);
+        for(size_t i = 0; i < result.size(); i += 3)
+        {
+            const glm::dvec3 a(vertices[result[i]].Position), b(vertices[result[i + 1]].Position), c(vertices[result[i + 2]].Position);
+            const glm::dvec3 cross = glm::cross(b - a, c - a);
+            const double area = glm::length(cross);
+            if(area == 0.0)
+                continue;
+            const glm::dvec3 normal = cross / area;
+            Quadric plane;
+            plane.addPlane(normal, -glm::dot(normal, a), area);
+            for(int k = 0; k < 3; k++)
+                quadrics[canonical[result[i + k]]].add(plane);
+        }
+
+        struct Collapse
+        {
+            unsigned int from; // canonical point that goes away
+            unsigned int to;   // vertex it becomes, as used by the triangles along the edge
+            float cost;
+        };
+        const double maxCost = double(maxError) * double(maxError);
+        std::vector<unsigned int> remap(vertexCount);
+        std::vector<bool> touched(vertexCount);
+        std::vector<unsigned int> triangleOffsets(vertexCount + 1), triangleList;
+        double largest = 0.0;
+
+        while(result.size() > targetIndexCount)
+        {
+            // triangles around every point
+            std::fill(triangleOffsets.begin(), triangleOffsets.end(), 0u);
+            for(unsigned int index : result)
+                triangleOffsets[canonical[index] + 1]++;
+            for(size_t v = 0; v < vertexCount; v++)
+                triangleOffsets[v + 1] += triangleOffsets[v];
+            triangleList.resize(result.size());
+            std::vector<unsigned int> filled(triangleOffsets.begin(), triangleOffsets.end() - 1);
+            for(size_t i = 0; i < result.size(); i++)
+                triangleList[filled[canonical[result[i]]]++] = static_cast<unsigned int>(i / 3);
+
+            // every edge in both directions, cheapest first
+            std::vector<Collapse> collapses;
+            collapses.reserve(result.size() * 2);
+            for(size_t i = 0; i < result.size(); i += 3)
+                for(int k = 0; k < 3; k++)
+                {
+                    const unsigned int a = result[i + k], b = result[i + (k + 1) % 3];
+                    const unsigned int ca = canonical[a], cb = canonical[b];
+                    if(ca == cb)
+                        continue;
+                    Quadric q = quadrics[ca];
+                    q.add(quadrics[cb]);
+                    if(!locked[ca])
+                        collapses.push_back({ ca, b, float(q.error(vertices[b].Position)) });
+                    if(!locked[cb])
+                        collapses.push_back({ cb, a, float(q.error(vertices[a].Position)) });
+                }
+            std::sort(collapses.begin(), collapses.end(), [](const Collapse &x, const Collapse &y) { return x.cost < y.cost; });
+
+            // as many as possible in one pass; the triangles around a collapse can't take part in another one until
+            // the next pass, so the flip test below always sees the current surface
+            for(size_t v = 0; v < vertexCount; v++)
+                remap[v] = static_cast<unsigned int>(v);
+            std::fill(touched.begin(), touched.end(), false);
+            size_t triangles = result.size() / 3;
+            size_t applied = 0;
+            for(const Collapse &collapse : collapses)
+            {
+                if(triangles * 3 <= targetIndexCount || collapse.cost > maxCost)
+                    break;
+                const unsigned int from = collapse.from, to = canonical[collapse.to];
+                if(touched[from] || touched[to])
+                    continue;
+
+                // reject collapses that would flip a triangle around from
+                bool flips = false;
+                size_t removed = 0;
+                const glm::vec3 target = vertices[collapse.to].Position;
+                for(unsigned int j = triangleOffsets[from]; j < triangleOffsets[from + 1] && !flips; j++)
+                {
+                    const unsigned int *triangle = &result[triangleList[j] * 3];
+                    glm::vec3 before[3], after[3];
+                    bool hasTarget = false;
+                    for(int k = 0; k < 3; k++)
+                    {
+                        before[k] = after[k] = vertices[triangle[k]].Position;
+                        hasTarget = hasTarget || canonical[triangle[k]] == to;
+                        if(canonical[triangle[k]] == from)
+                            after[k] = target;
+                    }
+                    if(hasTarget)
+                    {
+                        removed++;
+                        continue;
+                    }
+                    const glm::vec3 oldNormal = glm::cross(before[1] - before[0], before[2] - before[0]);
+                    const glm::vec3 newNormal = glm::cross(after[1] - after[0], after[2] - after[0]);
+                    flips = glm::dot(oldNormal, newNormal) <= 0.0f;
+                }
+                if(flips)
+                    continue;
+
+                // from only has one vertex (it isn't on a seam), which now becomes to
+                remap[from] = collapse.to;
+                quadrics[to].add(quadrics[from]);
+                touched[from] = touched[to] = true;
+                for(unsigned int j = triangleOffsets[from]; j < triangleOffsets[from + 1]; j++)
+                    for(int k = 0; k < 3; k++)
+                        touched[canonical[result[triangleList[j] * 3 + k]]] = true;
+                largest = std::max(largest, double(collapse.cost));
+                triangles -= removed;
+                applied++;
+            }
+            if(applied == 0)
+                break;
+
+            // rewrite the triangles and drop the ones that collapsed to a line
+            size_t write = 0;
+            for(size_t i = 0; i < result.size(); i += 3)
+            {
+                const unsigned int a = remap[result[i]], b = remap[result[i + 1]], c = remap[result[i + 2]];
+                if(canonical[a] == canonical[b] || canonical[b] == canonical[c] || canonical[a] == canonical[c])
+                    continue;
+                result[write++] = a;
+                result[write++] = b;
+                result[write++] = c;
+            }
+            result.resize(write);
+        }
+        if(error)
+            *error = float(std::sqrt(largest));
+        return result;
+    }
+
+    struct Level
+    {
+        std::vector<unsigned int> indices;
+        float error; // see simplify
+    };
+
+    // Up to levels simplified versions of a mesh, each with about ratio times the triangles of the one before and
+    // ordered for the vertex cache. Every level is simplified from the full mesh, so its error is measured against the
+    // original surface. Stops early once a level wouldn't get any simpler
+    inline std::vector<Level> buildLevels(const std::vector<Vertex> &vertices, const std::vector<unsigned int> &indices,
+                                          int levels, float ratio = 0.5f, float maxError = 1e30f)
+    {
+        std::vector<Level> result;
+        size_t previous = indices.size();
+        for(int level = 1; level <= levels; level++)
+        {
+            const size_t target = size_t(double(indices.size()) * std::pow(double(ratio), level)) / 3 * 3;
+            Level lod;
+            lod.indices = simplify(vertices, indices, target, maxError, &lod.error);
+            if(lod.indices.empty() || lod.indices.size() > previous * 9 / 10)
+                break;
+            MeshOptimizer::optimizeVertexCache(lod.indices, vertices.size());
+            previous = lod.indices.size();
+            result.push_back(std::move(lod));
+        }
+        return result;
+    }
+
+    // The coarsest of the levels whose error, seen from distance and scaled by scale, covers at most maxPixels on the
+    // screen. pixelsPerUnit is the size in pixels of one unit at distance 1: viewport height / (2 tan(fovy / 2))
+    inline int selectLevel(const float *errors, int count, float scale, float distance, float pixelsPerUnit, float maxPixels)
+    {
+        const float allowed = maxPixels * std::max(distance, 1e-6f) / (pixelsPerUnit * scale);
+        int level = 0;
+        while(level + 1 < count && errors[level + 1] <= allowed)
+            level++;
+        return level;
+    }
+}
+#endif
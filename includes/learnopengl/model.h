@@ -11,13 +11,20 @@
 #include <assimp/postprocess.h>
 
 #include <learnopengl/mesh.h>
+#include <learnopengl/mesh_cache.h>
+#include <learnopengl/mesh_optimizer.h>
 #include <learnopengl/shader.h>
+#include <learnopengl/texture_loader.h>
+#include <learnopengl/texture_registry.h>
+#include <learnopengl/thread_pool.h>
 
+#include <algorithm>
 #include <string>
 #include <fstream>
 #include <sstream>
 #include <iostream>
 #include <map>
+#include <unordered_map>
 #include <vector>
 using namespace std;
 
@@ -31,117 +38,231 @@ public:
     vector<Mesh>    meshes;
     string directory;
     bool gammaCorrection;
+    bool asyncTextures;     // stream textures in through AsyncTextureLoader; call its update() once per frame.
+    bool compactVertices;   // upload StaticVertex/SkinnedVertex instead of Vertex, for shaders that decode them (see Mesh).
 
     // constructor, expects a filepath to a 3D model.
-    Model(string const &path, bool gamma = false) : gammaCorrection(gamma)
+    Model(string const &path, bool gamma = false, bool async = false, bool compact = false)
+        : gammaCorrection(gamma), asyncTextures(async), compactVertices(compact)
     {
         loadModel(path);
     }
 
+    // textures are shared between models through the TextureRegistry, so a model owns references rather than copies
+    Model(const Model&) = delete;
+    Model& operator=(const Model&) = delete;
+    Model(Model&&) = default;
+
+    ~Model()
+    {
+        for(const Texture &texture : textures_loaded)
+            TextureRegistry::instance().release(texture.id);
+    }
+
     // draws the model, and thus all its meshes
     void Draw(Shader &shader)
     {
         for(unsigned int i = 0; i < meshes.size(); i++)
             meshes[i].Draw(shader);
     }
+
+    // Simplifies every mesh into up to levels coarser levels of detail (see Mesh::setLevels), in parallel
+    void generateLods(int levels, float ratio = 0.5f)
+    {
+        vector<vector<MeshSimplifier::Level>> results(meshes.size());
+        ThreadPool::shared().parallelFor(meshes.size(), [&](size_t i)
+        {
+            results[i] = MeshSimplifier::buildLevels(meshes[i].vertices, meshes[i].indices, levels, ratio);
+        });
+        for(size_t i = 0; i < meshes.size(); i++)
+            meshes[i].setLevels(results[i]);
+    }
+
+    // levels every mesh has, and the error of a level over all meshes, for picking one level for the whole model
+    int lodCount() const
+    {
+        size_t count = meshes.empty() ? 1 : meshes[0].lods.size();
+        for(const Mesh &mesh : meshes)
+            count = std::min(count, mesh.lods.size());
+        return static_cast<int>(count);
+    }
+
+    float lodError(int lod) const
+    {
+        float error = 0.0f;
+        for(const Mesh &mesh : meshes)
+            error = std::max(error, mesh.lods[lod].error);
+        return error;
+    }
+
+    // GPU memory of all vertex buffers, in bytes
+    size_t vertexBufferSize() const
+    {
+        size_t size = 0;
+        for(const Mesh &mesh : meshes)
+            size += mesh.vertexBufferSize();
+        return size;
+    }
     
 private:
+    unordered_map<string, size_t> textureIndex; // type|path -> index into textures_loaded
+
     // loads a model with supported ASSIMP extensions from file and stores the resulting meshes in the meshes vector.
     void loadModel(string const &path)
     {
+        const unsigned int importFlags = aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_FlipUVs | aiProcess_CalcTangentSpace;
+        // retrieve the directory path of the filepath
+        directory = path.substr(0, path.find_last_of('/'));
+
+        // a valid mesh cache lets us skip ASSIMP entirely
+        if(MeshCache::enabled() && loadFromCache(path, importFlags))
+            return;
+
         // read file via ASSIMP
         Assimp::Importer importer;
-        const aiScene* scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_FlipUVs | aiProcess_CalcTangentSpace);
+        const aiScene* scene = importer.ReadFile(path, importFlags);
         // check for errors
         if(!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) // if is Not Zero
         {
             cout << "ERROR::ASSIMP:: " << importer.GetErrorString() << endl;
             return;
         }
-        // retrieve the directory path of the filepath
-        directory = path.substr(0, path.find_last_of('/'));
 
         // process ASSIMP's root node recursively
         processNode(scene->mRootNode, scene);
+
+        if(MeshCache::enabled())
+            MeshCache::write(path, importFlags, meshes);
     }
 
-    // processes a node in a recursive fashion. Processes each individual mesh located at the node and repeats this process on its children nodes (if any).
+    // builds the meshes from "<path>.meshcache" if it is up to date, uploading the cached arrays straight to the GPU.
+    bool loadFromCache(string const &path, unsigned int importFlags)
+    {
+        return MeshCache::read(path, importFlags, [this](const Vertex *vertices, uint32_t numVertices, const unsigned int *indices, uint32_t numIndices, vector<Texture> textures)
+        {
+            for(Texture &texture : textures)
+                texture = loadTexture(texture.path.c_str(), texture.type);
+            meshes.emplace_back(vertices, numVertices, indices, numIndices, std::move(textures), compactVertices);
+        });
+    }
+
+    // CPU side result of converting one aiMesh, produced on a worker thread
+    struct MeshData
+    {
+        vector<Vertex> vertices;
+        vector<unsigned int> indices;
+        MeshOptimizer::CacheStats before, after; // in Assimp's order and optimized
+    };
+
+    // collects the meshes of the node tree in depth-first order, converts them in parallel (one task per mesh)
+    // and then loads textures and uploads the meshes in that same order on the thread owning the GL context.
     void processNode(aiNode *node, const aiScene *scene)
     {
-        // process each mesh located at the current node
-        for(unsigned int i = 0; i < node->mNumMeshes; i++)
+        vector<aiMesh*> sceneMeshes;
+        collectMeshes(node, scene, sceneMeshes);
+
+        vector<MeshData> meshData(sceneMeshes.size());
+        ThreadPool::shared().parallelFor(sceneMeshes.size(), [&](size_t i)
         {
-            // the node object only contains indices to index the actual objects in the scene. 
-            // the scene contains all the data, node is just to keep stuff organized (like relations between nodes).
-            aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
-            meshes.push_back(processMesh(mesh, scene));
-        }
-        // after we've processed all of the meshes (if any) we then recursively process each of the children nodes
-        for(unsigned int i = 0; i < node->mNumChildren; i++)
+            processMesh(sceneMeshes[i], meshData[i]);
+        });
+
+        if(MeshOptimizer::statsEnabled())
+            printCacheStats(meshData);
+
+        meshes.reserve(meshes.size() + sceneMeshes.size());
+        for(size_t i = 0; i < sceneMeshes.size(); i++)
         {
-            processNode(node->mChildren[i], scene);
+            vector<Texture> textures = loadMeshTextures(sceneMeshes[i], scene);
+            meshes.emplace_back(std::move(meshData[i].vertices), std::move(meshData[i].indices), std::move(textures), compactVertices);
         }
+    }
 
+    // gathers the meshes of a node and, recursively, of its children nodes (if any).
+    void collectMeshes(aiNode *node, const aiScene *scene, vector<aiMesh*> &out)
+    {
+        // the node object only contains indices to index the actual objects in the scene. 
+        // the scene contains all the data, node is just to keep stuff organized (like relations between nodes).
+        for(unsigned int i = 0; i < node->mNumMeshes; i++)
+            out.push_back(scene->mMeshes[node->mMeshes[i]]);
+        for(unsigned int i = 0; i < node->mNumChildren; i++)
+            collectMeshes(node->mChildren[i], scene, out);
     }
 
-    Mesh processMesh(aiMesh *mesh, const aiScene *scene)
+    // converts the vertices and faces of an aiMesh. Touches neither GL nor the model, so it runs on worker threads.
+    static void processMesh(const aiMesh *mesh, MeshData &data)
     {
-        // data to fill
-        vector<Vertex> vertices;
-        vector<unsigned int> indices;
-        vector<Texture> textures;
+        vector<Vertex> &vertices = data.vertices;
+        vector<unsigned int> &indices = data.indices;
+        vertices.resize(mesh->mNumVertices);
 
+        const bool hasNormals = mesh->HasNormals();
+        // a vertex can contain up to 8 different texture coordinates. We thus make the assumption that we won't 
+        // use models where a vertex can have multiple texture coordinates so we always take the first set (0).
+        const aiVector3D *texCoords = mesh->mTextureCoords[0];
+        const bool hasTangents = texCoords && mesh->HasTangentsAndBitangents();
         // walk through each of the mesh's vertices
         for(unsigned int i = 0; i < mesh->mNumVertices; i++)
         {
-            Vertex vertex;
-            glm::vec3 vector; // we declare a placeholder vector since assimp uses its own vector class that doesn't directly convert to glm's vec3 class so we transfer the data to this placeholder glm::vec3 first.
+            Vertex &vertex = vertices[i];
             // positions
-            vector.x = mesh->mVertices[i].x;
-            vector.y = mesh->mVertices[i].y;
-            vector.z = mesh->mVertices[i].z;
-            vertex.Position = vector;
+            vertex.Position = glm::vec3(mesh->mVertices[i].x, mesh->mVertices[i].y, mesh->mVertices[i].z);
             // normals
-            if (mesh->HasNormals())
-            {
-                vector.x = mesh->mNormals[i].x;
-                vector.y = mesh->mNormals[i].y;
-                vector.z = mesh->mNormals[i].z;
-                vertex.Normal = vector;
-            }
+            if (hasNormals)
+                vertex.Normal = glm::vec3(mesh->mNormals[i].x, mesh->mNormals[i].y, mesh->mNormals[i].z);
             // texture coordinates
-            if(mesh->mTextureCoords[0]) // does the mesh contain texture coordinates?
+            if(texCoords)
+                vertex.TexCoords = glm::vec2(texCoords[i].x, texCoords[i].y);
+            // tangent and bitangent
+            if(hasTangents)
             {
-                glm::vec2 vec;
-                // a vertex can contain up to 8 different texture coordinates. We thus make the assumption that we won't 
-                // use models where a vertex can have multiple texture coordinates so we always take the first set (0).
-                vec.x = mesh->mTextureCoords[0][i].x; 
-                vec.y = mesh->mTextureCoords[0][i].y;
-                vertex.TexCoords = vec;
-                // tangent
-                vector.x = mesh->mTangents[i].x;
-                vector.y = mesh->mTangents[i].y;
-                vector.z = mesh->mTangents[i].z;
-                vertex.Tangent = vector;
-                // bitangent
-                vector.x = mesh->mBitangents[i].x;
-                vector.y = mesh->mBitangents[i].y;
-                vector.z = mesh->mBitangents[i].z;
-                vertex.Bitangent = vector;
+                vertex.Tangent = glm::vec3(mesh->mTangents[i].x, mesh->mTangents[i].y, mesh->mTangents[i].z);
+                vertex.Bitangent = glm::vec3(mesh->mBitangents[i].x, mesh->mBitangents[i].y, mesh->mBitangents[i].z);
             }
-            else
-                vertex.TexCoords = glm::vec2(0.0f, 0.0f);
-
-            vertices.push_back(vertex);
         }
-        // now wak through each of the mesh's faces (a face is a mesh its triangle) and retrieve the corresponding vertex indices.
+        // now walk through each of the mesh's faces (a face is a mesh its triangle) and retrieve the corresponding vertex indices.
+        size_t numIndices = 0;
+        for(unsigned int i = 0; i < mesh->mNumFaces; i++)
+            numIndices += mesh->mFaces[i].mNumIndices;
+        indices.resize(numIndices);
+        unsigned int *out = indices.data();
         for(unsigned int i = 0; i < mesh->mNumFaces; i++)
         {
-            aiFace face = mesh->mFaces[i];
+            const aiFace &face = mesh->mFaces[i];
             // retrieve all indices of the face and store them in the indices vector
             for(unsigned int j = 0; j < face.mNumIndices; j++)
-                indices.push_back(face.mIndices[j]);        
+                *out++ = face.mIndices[j];
+        }
+        // reorder for the post-transform cache and for vertex fetch
+        MeshOptimizer::optimize(vertices, indices, MeshOptimizer::overdrawEnabled(), &data.before, &data.after);
+    }
+
+    // ACMR and ATVR of the whole model before and after optimizing, weighted by triangles and vertices
+    void printCacheStats(const vector<MeshData> &meshData) const
+    {
+        double triangles = 0.0, vertexCount = 0.0;
+        double acmrBefore = 0.0, acmrAfter = 0.0, atvrBefore = 0.0, atvrAfter = 0.0;
+        for(const MeshData &data : meshData)
+        {
+            const double meshTriangles = double(data.indices.size() / 3), meshVertices = double(data.vertices.size());
+            triangles += meshTriangles;
+            vertexCount += meshVertices;
+            acmrBefore += data.before.acmr * meshTriangles;
+            acmrAfter += data.after.acmr * meshTriangles;
+            atvrBefore += data.before.atvr * meshVertices;
+            atvrAfter += data.after.atvr * meshVertices;
         }
+        if(triangles == 0.0)
+            return;
+        cout << directory << ": " << meshData.size() << " meshes, " << triangles << " triangles, ACMR "
+             << acmrBefore / triangles << " -> " << acmrAfter / triangles << ", ATVR "
+             << atvrBefore / vertexCount << " -> " << atvrAfter / vertexCount << endl;
+    }
+
+    // loads the material textures of a mesh; issues GL calls so this stays on the context thread.
+    vector<Texture> loadMeshTextures(const aiMesh *mesh, const aiScene *scene)
+    {
+        vector<Texture> textures;
         // process materials
         aiMaterial* material = scene->mMaterials[mesh->mMaterialIndex];    
         // we assume a convention for sampler names in the shaders. Each diffuse texture should be named
@@ -164,8 +285,7 @@ private:
         std::vector<Texture> heightMaps = loadMaterialTextures(material, aiTextureType_AMBIENT, "texture_height");
         textures.insert(textures.end(), heightMaps.begin(), heightMaps.end());
         
-        // return a mesh object created from the extracted mesh data
-        return Mesh(vertices, indices, textures);
+        return textures;
     }
 
     // checks all material textures of a given type and loads the textures if they're not loaded yet.
@@ -177,29 +297,41 @@ private:
         {
             aiString str;
             mat->GetTexture(type, i, &str);
-            // check if texture was loaded before and if so, continue to next iteration: skip loading a new texture
-            bool skip = false;
-            for(unsigned int j = 0; j < textures_loaded.size(); j++)
-            {
-                if(std::strcmp(textures_loaded[j].path.data(), str.C_Str()) == 0)
-                {
-                    textures.push_back(textures_loaded[j]);
-                    skip = true; // a texture with the same filepath has already been loaded, continue to next one. (optimization)
-                    break;
-                }
-            }
-            if(!skip)
-            {   // if texture hasn't been loaded already, load it
-                Texture texture;
-                texture.id = TextureFromFile(str.C_Str(), this->directory);
-                texture.type = typeName;
-                texture.path = str.C_Str();
-                textures.push_back(texture);
-                textures_loaded.push_back(texture);  // store it as texture loaded for entire model, to ensure we won't unnecessary load duplicate textures.
-            }
+            textures.push_back(loadTexture(str.C_Str(), typeName));
         }
         return textures;
     }
+
+    // loads the texture at path (relative to the model's directory) unless it was loaded before.
+    Texture loadTexture(const char *path, const string &typeName)
+    {
+        // check if texture was loaded before and if so, skip loading a new texture
+        const string index = typeName + '|' + path; // the type decides the format and placeholder
+        auto loaded = textureIndex.find(index);
+        if(loaded != textureIndex.end())
+            return textures_loaded[loaded->second]; // a texture with the same filepath has already been loaded. (optimization)
+        // if this model hasn't used the texture yet, get it from the registry, which shares it with every other model
+        Texture texture;
+        string filename = this->directory + '/' + path;
+        // only color maps are stored in sRGB; normal, specular and height maps hold linear data
+        const bool srgb = gammaCorrection && typeName == "texture_diffuse";
+        const bool flatNormal = typeName == "texture_normal";
+        unsigned int flags = srgb ? TextureRegistry::SRGB : 0;
+        if(asyncTextures)
+            flags |= TextureRegistry::ASYNC | (flatNormal ? TextureRegistry::PLACEHOLDER_NORMAL : 0);
+        texture.id = TextureRegistry::instance().acquire(filename, flags, [&]()
+        {
+            if(asyncTextures)
+                return AsyncTextureLoader::instance().load(filename, srgb,
+                    flatNormal ? AsyncTextureLoader::PLACEHOLDER_NORMAL : AsyncTextureLoader::PLACEHOLDER_WHITE);
+            return TextureFromFile(path, this->directory, srgb);
+        });
+        texture.type = typeName;
+        texture.path = path;
+        textureIndex[index] = textures_loaded.size();
+        textures_loaded.push_back(texture);  // store it as texture loaded for entire model, to ensure we won't unnecessary load duplicate textures.
+        return texture;
+    }
 };
 
 
@@ -222,9 +354,14 @@ unsigned int TextureFromFile(const char *path, const string &directory, bool gam
             format = GL_RGB;
         else if (nrComponents == 4)
             format = GL_RGBA;
+        GLenum internalFormat = format;
+        if (gamma && format == GL_RGB)
+            internalFormat = GL_SRGB;
+        else if (gamma && format == GL_RGBA)
+            internalFormat = GL_SRGB_ALPHA;
 
         glBindTexture(GL_TEXTURE_2D, textureID);
-        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
+        glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, format, GL_UNSIGNED_BYTE, data);
         glGenerateMipmap(GL_TEXTURE_2D);
 
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
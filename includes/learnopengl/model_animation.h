@@ -11,6 +11,7 @@
 #include <assimp/postprocess.h>
 
 #include <learnopengl/mesh.h>
+#include <learnopengl/mesh_optimizer.h>
 #include <learnopengl/shader.h>
 
 #include <string>
@@ -32,11 +33,12 @@ public:
     vector<Mesh>    meshes;
     string directory;
     bool gammaCorrection;
+    bool compactVertices;   // upload StaticVertex/SkinnedVertex instead of Vertex, see Mesh
 	
 	
 
     // constructor, expects a filepath to a 3D model.
-    Model(string const &path, bool gamma = false) : gammaCorrection(gamma)
+    Model(string const &path, bool gamma = false, bool compact = false) : gammaCorrection(gamma), compactVertices(compact)
     {
         loadModel(path);
     }
@@ -47,6 +49,15 @@ public:
         for(unsigned int i = 0; i < meshes.size(); i++)
             meshes[i].Draw(shader);
     }
+
+    // GPU memory of all vertex buffers, in bytes
+    size_t vertexBufferSize() const
+    {
+        size_t size = 0;
+        for(const Mesh &mesh : meshes)
+            size += mesh.vertexBufferSize();
+        return size;
+    }
     
 	auto& GetBoneInfoMap() { return m_BoneInfoMap; }
 	int& GetBoneCount() { return m_BoneCounter; }
@@ -113,7 +124,7 @@ private:
 
 		for (unsigned int i = 0; i < mesh->mNumVertices; i++)
 		{
-			Vertex vertex;
+			Vertex vertex = {}; // no tangents are imported, keep them zero rather than garbage for packing
 			SetVertexBoneDataToDefault(vertex);
 			vertex.Position = AssimpGLMHelpers::GetGLMVec(mesh->mVertices[i]);
 			vertex.Normal = AssimpGLMHelpers::GetGLMVec(mesh->mNormals[i]);
@@ -149,7 +160,14 @@ private:
 
 		ExtractBoneWeightForVertices(vertices,mesh,scene);
 
-		return Mesh(vertices, indices, textures);
+		// reorder for the post-transform cache and for vertex fetch, once the bone weights found their vertices
+		MeshOptimizer::CacheStats before, after;
+		MeshOptimizer::optimize(vertices, indices, MeshOptimizer::overdrawEnabled(), &before, &after);
+		if (MeshOptimizer::statsEnabled())
+			cout << mesh->mName.C_Str() << ": " << indices.size() / 3 << " triangles, ACMR " << before.acmr << " -> " << after.acmr
+				<< ", ATVR " << before.atvr << " -> " << after.atvr << endl;
+
+		return Mesh(vertices, indices, textures, compactVertices);
 	}
 
 	void SetVertexBoneData(Vertex& vertex, int boneID, float weight)
@@ -0,0 +1,174 @@
+#ifndef PROGRAM_CACHE_H
+#define PROGRAM_CACHE_H
+
+#include <glad/glad.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <initializer_list>
+#include <iostream>
+#include <string>
+#include <vector>
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+// On-disk cache of linked program binaries (glGetProgramBinary/glProgramBinary). A program is keyed by a hash of
+// all its stage sources and the driver's vendor, renderer and version strings, so a driver update simply misses.
+// Binaries live in $LOGL_SHADER_CACHE (default: ./shader_cache); set LOGL_NO_SHADER_CACHE to always compile.
+// Hits, misses and rejected binaries are counted and reported when the process exits.
+namespace ProgramCache
+{
+    const uint32_t MAGIC = 0x4E42474C; // "LGBN"
+
+    struct Stats
+    {
+        unsigned int hits = 0;
+        unsigned int misses = 0;
+        unsigned int rejected = 0; // cached binary found, but the driver refused it
+
+        ~Stats()
+        {
+            if (hits + misses > 0)
+                report();
+        }
+        void report() const
+        {
+            std::cout << "shader program cache: " << hits << " hits, " << misses << " misses, " << rejected << " rejected" << std::endl;
+        }
+    };
+
+    inline Stats& stats()
+    {
+        static Stats s;
+        return s;
+    }
+
+    // the driver has to support program binaries in at least one format
+    inline bool enabled()
+    {
+        static const bool supported = [] {
+            if (getenv("LOGL_NO_SHADER_CACHE") || !glad_glProgramBinary || !glad_glGetProgramBinary || !glad_glProgramParameteri)
+                return false;
+            GLint formats = 0;
+            glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+            return formats > 0;
+        }();
+        return supported;
+    }
+
+    inline std::string directory()
+    {
+        const char *dir = getenv("LOGL_SHADER_CACHE");
+        return dir ? dir : "shader_cache";
+    }
+
+    inline void hashBytes(uint64_t &hash, const char *data, size_t size)
+    {
+        for (size_t i = 0; i < size; i++)
+        {
+            hash ^= static_cast<unsigned char>(data[i]);
+            hash *= 0x100000001b3ULL;
+        }
+    }
+
+    // 64-bit FNV-1a over every stage source (in order) and the driver identification strings
+    inline uint64_t key(std::initializer_list<const std::string*> sources)
+    {
+        uint64_t hash = 0xcbf29ce484222325ULL;
+        for (const std::string *source : sources)
+        {
+            uint64_t size = source->size();
+            hashBytes(hash, reinterpret_cast<const char*>(&size), sizeof(size));
+            hashBytes(hash, source->data(), source->size());
+        }
+        for (GLenum name : { GL_VENDOR, GL_RENDERER, GL_VERSION })
+        {
+            const char *value = reinterpret_cast<const char*>(glGetString(name));
+            if (value)
+                hashBytes(hash, value, strlen(value) + 1);
+        }
+        return hash;
+    }
+
+    inline std::string path(uint64_t key)
+    {
+        char name[32];
+        snprintf(name, sizeof(name), "%016llx.bin", static_cast<unsigned long long>(key));
+        return directory() + "/" + name;
+    }
+
+    // loads the cached binary into program; returns true if the program is linked and ready to use
+    inline bool load(GLuint program, uint64_t key)
+    {
+        if (!enabled())
+            return false;
+        std::ifstream file(path(key), std::ios::binary);
+        uint32_t header[3]; // magic, binary format, binary length
+        if (!file || !file.read(reinterpret_cast<char*>(header), sizeof(header)) || header[0] != MAGIC)
+        {
+            stats().misses++;
+            return false;
+        }
+        std::vector<char> binary(header[2]);
+        if (!file.read(binary.data(), binary.size()))
+        {
+            stats().misses++;
+            return false;
+        }
+        glProgramBinary(program, header[1], binary.data(), static_cast<GLsizei>(binary.size()));
+        GLint success = 0;
+        glGetProgramiv(program, GL_LINK_STATUS, &success);
+        if (!success)
+        {
+            stats().rejected++;
+            stats().misses++;
+            return false;
+        }
+        stats().hits++;
+        return true;
+    }
+
+    // call before glLinkProgram so the driver keeps the binary around for store()
+    inline void prepare(GLuint program)
+    {
+        if (enabled())
+            glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+
+    // writes the binary of a successfully linked program
+    inline void store(GLuint program, uint64_t key)
+    {
+        if (!enabled())
+            return;
+        GLint success = 0, length = 0;
+        glGetProgramiv(program, GL_LINK_STATUS, &success);
+        glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+        if (!success || length <= 0)
+            return;
+        std::vector<char> binary(length);
+        GLenum format = 0;
+        glGetProgramBinary(program, length, &length, &format, binary.data());
+
+#ifdef _WIN32
+        _mkdir(directory().c_str());
+#else
+        mkdir(directory().c_str(), 0755);
+#endif
+        std::string target = path(key);
+        std::string tmp = target + ".tmp";
+        std::ofstream file(tmp, std::ios::binary | std::ios::trunc);
+        uint32_t header[3] = { MAGIC, format, static_cast<uint32_t>(length) };
+        file.write(reinterpret_cast<const char*>(header), sizeof(header));
+        file.write(binary.data(), length);
+        file.close();
+        if (!file || std::rename(tmp.c_str(), target.c_str()) != 0)
+            std::remove(tmp.c_str());
+    }
+}
+#endif
@@ -8,6 +8,9 @@
 #include <sstream>
 #include <iostream>
 
+#include <learnopengl/program_cache.h>
+#include <learnopengl/uniform.h>
+
 class Shader
 {
 public:
@@ -46,7 +49,15 @@ public:
         }
         const char* vShaderCode = vertexCode.c_str();
         const char * fShaderCode = fragmentCode.c_str();
-        // 2. compile shaders
+        // 2. reuse a cached program binary if this driver built the same sources before
+        ID = glCreateProgram();
+        const uint64_t binaryKey = ProgramCache::key({ &vertexCode, &fragmentCode });
+        if(ProgramCache::load(ID, binaryKey))
+        {
+            uniforms.build(ID);
+            return;
+        }
+        // 3. compile shaders
         unsigned int vertex, fragment;
         // vertex shader
         vertex = glCreateShader(GL_VERTEX_SHADER);
@@ -59,11 +70,13 @@ public:
         glCompileShader(fragment);
         checkCompileErrors(fragment, "FRAGMENT");
         // shader Program
-        ID = glCreateProgram();
         glAttachShader(ID, vertex);
         glAttachShader(ID, fragment);
+        ProgramCache::prepare(ID);
         glLinkProgram(ID);
         checkCompileErrors(ID, "PROGRAM");
+        ProgramCache::store(ID, binaryKey);
+        uniforms.build(ID);
         // delete the shaders as they're linked into our program now and no longer necessary
         glDeleteShader(vertex);
         glDeleteShader(fragment);
@@ -78,20 +91,36 @@ public:
     // ------------------------------------------------------------------------
     void setBool(const std::string &name, bool value) const
     {         
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value); 
+        glUniform1i(uniforms.location(name.c_str()), (int)value); 
     }
     // ------------------------------------------------------------------------
     void setInt(const std::string &name, int value) const
     { 
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), value); 
+        glUniform1i(uniforms.location(name.c_str()), value); 
     }
     // ------------------------------------------------------------------------
     void setFloat(const std::string &name, float value) const
     { 
-        glUniform1f(glGetUniformLocation(ID, name.c_str()), value); 
+        glUniform1f(uniforms.location(name.c_str()), value); 
+    }
+
+    // ------------------------------------------------------------------------
+    // resolves a uniform once so it can be set in a hot loop without a string or driver lookup
+    template<typename T>
+    UniformHandle<T> handle(const std::string &name) const
+    {
+        UniformHandle<T> handle;
+        handle.location = uniforms.location(name.c_str());
+        return handle;
+    }
+    GLint uniformLocation(const char *name) const
+    {
+        return uniforms.location(name);
     }
 
 private:
+    UniformTable uniforms;
+
     // utility function for checking shader compilation/linking errors.
     // ------------------------------------------------------------------------
     void checkCompileErrors(unsigned int shader, std::string type)
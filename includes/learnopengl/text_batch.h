@@ -0,0 +1,195 @@
+#ifndef TEXT_BATCH_H
+#define TEXT_BATCH_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/packing.hpp>
+
+#include <learnopengl/glyph_atlas.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Collects the lines of text of a frame into one vertex buffer over a GlyphAtlas and draws them with a single draw
+// call. Vertices are a vec4 at location 0 (position, texture coords, as the text shaders always read them) and the
+// color as a normalized vec4 at location 1.
+// Laying out a string happens once: the quads of every string are cached at scale 1, and later frames only place
+// them. And when a frame queues the same lines as the one before (the usual case for menus and labels), nothing is
+// rebuilt or uploaded at all, draw() just draws the buffer again.
+class TextBatch
+{
+public:
+    // With yDown (a projection with the origin at the top left) the y of a line is the top of its capital
+    // letters, otherwise it's the baseline
+    TextBatch(const GlyphAtlas &atlas, bool yDown) : atlas(atlas), yDown(yDown)
+    {
+        glGenVertexArrays(1, &vao);
+        glGenBuffers(1, &vbo);
+        glBindVertexArray(vao);
+        glBindBuffer(GL_ARRAY_BUFFER, vbo);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, position));
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(Vertex), (void*)offsetof(Vertex, color));
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        glBindVertexArray(0);
+    }
+
+    ~TextBatch()
+    {
+        glDeleteBuffers(1, &vbo);
+        glDeleteVertexArrays(1, &vao);
+    }
+
+    TextBatch(const TextBatch&) = delete;
+    TextBatch& operator=(const TextBatch&) = delete;
+
+    // queues a line of text for the next draw()
+    void add(const std::string &text, float x, float y, float scale, const glm::vec3 &color)
+    {
+        const uint32_t packed = glm::packUnorm4x8(glm::vec4(color, 1.0f));
+        if (used < lines.size())
+        {
+            Line &line = lines[used++];
+            if (!changed && line.x == x && line.y == y && line.scale == scale && line.color == packed && line.text == text)
+                return;
+            line.text = text;
+            line.x = x;
+            line.y = y;
+            line.scale = scale;
+            line.color = packed;
+        }
+        else
+        {
+            lines.push_back(Line{ text, x, y, scale, packed });
+            used++;
+        }
+        changed = true;
+    }
+
+    // draws what was queued since the last draw() with the atlas on texture unit 0 and the shader in use
+    void draw()
+    {
+        if (used != lines.size())
+        {
+            lines.resize(used);
+            changed = true;
+        }
+        if (changed)
+            rebuild();
+        if (vertexCount > 0)
+        {
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_2D, atlas.texture());
+            glBindVertexArray(vao);
+            glDrawArrays(GL_TRIANGLES, 0, vertexCount);
+            glBindVertexArray(0);
+            glBindTexture(GL_TEXTURE_2D, 0);
+        }
+        used = 0;
+        changed = false;
+    }
+
+    // forgets the cached layouts, e.g. after the atlas was loaded again
+    void reset()
+    {
+        layouts.clear();
+        lines.clear();
+        used = 0;
+        changed = true;
+    }
+
+private:
+    struct Vertex
+    {
+        glm::vec2 position;
+        glm::vec2 texCoords;
+        uint32_t color;
+    };
+
+    // a glyph of a laid out string, relative to its start at scale 1
+    struct Quad
+    {
+        glm::vec2 min, max;     // top left and bottom right corner
+        glm::vec2 uvMin, uvMax;
+    };
+
+    struct Line
+    {
+        std::string text;
+        float x, y, scale;
+        uint32_t color;
+    };
+
+    // at most this many strings stay cached, so changing text (counters, timers) can't grow the cache forever
+    static const size_t MAX_LAYOUTS = 1024;
+
+    const std::vector<Quad> &layout(const std::string &text)
+    {
+        auto found = layouts.find(text);
+        if (found != layouts.end())
+            return found->second;
+        if (layouts.size() >= MAX_LAYOUTS)
+            layouts.clear();
+
+        std::vector<Quad> quads;
+        quads.reserve(text.size());
+        const float baseline = yDown ? float(atlas.capHeight()) : 0.0f;
+        const float up = yDown ? -1.0f : 1.0f; // direction of a glyph's bearing on the screen
+        float x = 0.0f;
+        for (char c : text)
+        {
+            const GlyphAtlas::Glyph &glyph = atlas.glyph(c);
+            if (glyph.size.x > 0 && glyph.size.y > 0)
+            {
+                Quad quad;
+                const float top = baseline + up * float(glyph.bearing.y);
+                quad.min = glm::vec2(x + float(glyph.bearing.x), top);
+                quad.max = glm::vec2(quad.min.x + float(glyph.size.x), top - up * float(glyph.size.y));
+                quad.uvMin = glyph.uvMin;
+                quad.uvMax = glyph.uvMax;
+                quads.push_back(quad);
+            }
+            x += float(glyph.advance >> 6); // advance is in 1/64 pixels
+        }
+        return layouts.emplace(text, std::move(quads)).first->second;
+    }
+
+    void rebuild()
+    {
+        vertices.clear();
+        for (const Line &line : lines)
+        {
+            const glm::vec2 origin(line.x, line.y);
+            for (const Quad &quad : layout(line.text))
+            {
+                const glm::vec2 min = origin + quad.min * line.scale, max = origin + quad.max * line.scale;
+                const Vertex topLeft = { min, quad.uvMin, line.color };
+                const Vertex topRight = { glm::vec2(max.x, min.y), glm::vec2(quad.uvMax.x, quad.uvMin.y), line.color };
+                const Vertex bottomLeft = { glm::vec2(min.x, max.y), glm::vec2(quad.uvMin.x, quad.uvMax.y), line.color };
+                const Vertex bottomRight = { max, quad.uvMax, line.color };
+                // counter-clockwise on the screen whichever way y points, as face culling may be on
+                vertices.insert(vertices.end(), { topLeft, bottomLeft, bottomRight, topLeft, bottomRight, topRight });
+            }
+        }
+        vertexCount = static_cast<GLsizei>(vertices.size());
+        // a new buffer every time the text changes, so the driver doesn't have to wait for the GPU to read the old one
+        glBindBuffer(GL_ARRAY_BUFFER, vbo);
+        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), vertices.data(), GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    const GlyphAtlas &atlas;
+    bool yDown;
+    std::unordered_map<std::string, std::vector<Quad>> layouts;
+    std::vector<Line> lines; // of the current frame; before the first add of a frame, those of the last one
+    size_t used = 0;         // lines added this frame
+    bool changed = true;     // whether this frame's lines differ from what the buffer holds
+    std::vector<Vertex> vertices;
+    GLsizei vertexCount = 0;
+    GLuint vao = 0, vbo = 0;
+};
+#endif
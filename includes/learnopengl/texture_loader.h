@@ -0,0 +1,338 @@
+#ifndef TEXTURE_LOADER_H
+#define TEXTURE_LOADER_H
+
+#include <glad/glad.h>
+
+#include <stb_image.h>
+
+#include <learnopengl/thread_pool.h>
+
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Streams textures in the background: load() immediately returns a texture name that holds a 1x1 placeholder,
+// the image is decoded and mipmapped on the shared ThreadPool, and update() - called once per frame on the GL
+// thread - copies it into the texture through a pixel unpack buffer, a few rows at a time, uploading at most a
+// given number of bytes per call so neither a burst of textures nor a single huge one stalls a frame. Levels go
+// up smallest first and the texture's base level follows them, so it sharpens as it streams in and never shows
+// storage that hasn't been written yet. A texture that is
+// deleted before its image arrives must be cancel()ed first (TextureRegistry does), or the upload would go to a
+// dead or reused name.
+class AsyncTextureLoader
+{
+public:
+    // RGBA placeholder colors
+    static const unsigned int PLACEHOLDER_WHITE  = 0xFFFFFFFF;
+    static const unsigned int PLACEHOLDER_NORMAL = 0xFFFF8080; // (0.5, 0.5, 1.0): a flat tangent space normal
+
+    static AsyncTextureLoader& instance()
+    {
+        static AsyncTextureLoader loader;
+        return loader;
+    }
+
+    // generate the mip chain on the worker threads; otherwise glGenerateMipmap runs on the GL thread once the
+    // whole image is uploaded, and the placeholder shows until then
+    bool cpuMipmaps = true;
+
+    unsigned int load(const std::string &filename, bool gamma = false, unsigned int placeholder = PLACEHOLDER_WHITE)
+    {
+        unsigned int textureID;
+        glGenTextures(1, &textureID);
+        glBindTexture(GL_TEXTURE_2D, textureID);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, &placeholder);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+        // a name can come back from glGenTextures once it's deleted, so images are matched by job rather than name
+        const unsigned int job = ++lastJob;
+        jobs[textureID] = job;
+        std::shared_ptr<Queue> queue = ready;
+        bool mipmaps = cpuMipmaps;
+        ThreadPool::shared().submit([queue, filename, textureID, job, gamma, placeholder, mipmaps]
+        {
+            std::unique_ptr<Image> image = decode(filename, mipmaps);
+            image->textureID = textureID;
+            image->job = job;
+            image->gamma = gamma;
+            image->placeholder = placeholder;
+            std::lock_guard<std::mutex> lock(queue->mutex);
+            queue->images.push_back(std::move(image));
+        });
+        return textureID;
+    }
+
+    // uploads decoded images until byteBudget bytes went up (always at least a row); returns the number of textures
+    // finished. An image that doesn't fit continues in the next call.
+    unsigned int update(size_t byteBudget = 16 * 1024 * 1024)
+    {
+        unsigned int finished = 0;
+        size_t bytes = 0;
+        while (bytes < byteBudget)
+        {
+            if (current && !waiting(*current))
+                current.reset(); // cancelled halfway
+            if (!current)
+            {
+                current = next();
+                if (!current)
+                    break;
+                if (!begin(*current))
+                {
+                    jobs.erase(current->textureID);
+                    current.reset();
+                    finished++;
+                    continue;
+                }
+            }
+            bytes += stream(*current, byteBudget - bytes);
+            if (current->level < 0)
+            {
+                jobs.erase(current->textureID);
+                current.reset();
+                finished++;
+            }
+        }
+        return finished;
+    }
+
+    // forgets a texture that is about to be deleted: its image is dropped instead of uploaded
+    void cancel(unsigned int textureID)
+    {
+        jobs.erase(textureID);
+    }
+
+    // textures whose real image hasn't been uploaded yet
+    unsigned int pendingCount() const { return static_cast<unsigned int>(jobs.size()); }
+
+    // blocks until every requested texture has been uploaded
+    void finish()
+    {
+        while (!jobs.empty())
+        {
+            if (update(~size_t(0)) == 0 && !current)
+                std::this_thread::yield();
+        }
+    }
+
+private:
+    struct Image
+    {
+        unsigned int textureID = 0;
+        unsigned int job = 0;
+        bool gamma = false;
+        unsigned int placeholder = PLACEHOLDER_WHITE;
+        int width = 0, height = 0, components = 0;
+        int levels = 0; // 0 if the mip chain still has to be generated
+        std::vector<unsigned char> pixels; // all levels, tightly packed one after the other
+        std::string filename;
+
+        // upload progress: the level being streamed (-1 once done), the next row of it and where each level starts
+        GLenum format = GL_RGBA, internalFormat = GL_RGBA;
+        int level = 0, row = 0;
+        std::vector<size_t> offsets;
+    };
+
+    struct Queue
+    {
+        std::mutex mutex;
+        std::deque<std::unique_ptr<Image>> images;
+    };
+
+    AsyncTextureLoader() : ready(std::make_shared<Queue>())
+    {
+        ThreadPool::shared(); // make sure the pool outlives the loader
+    }
+    ~AsyncTextureLoader()
+    {
+        if (pbo)
+            glDeleteBuffers(1, &pbo);
+    }
+
+    static std::unique_ptr<Image> decode(const std::string &filename, bool mipmaps)
+    {
+        std::unique_ptr<Image> image(new Image());
+        image->filename = filename;
+        unsigned char *data = stbi_load(filename.c_str(), &image->width, &image->height, &image->components, 0);
+        if (!data)
+            return image;
+
+        size_t size = size_t(image->width) * image->height * image->components;
+        image->pixels.assign(data, data + size);
+        stbi_image_free(data);
+        if (mipmaps)
+            buildMipChain(*image);
+        return image;
+    }
+
+    // appends every mip level to the base image with a 2x2 box filter
+    static void buildMipChain(Image &image)
+    {
+        const int c = image.components;
+        int w = image.width, h = image.height;
+        size_t total = size_t(w) * h * c;
+        int levels = 1;
+        for (int lw = w, lh = h; lw > 1 || lh > 1; levels++)
+        {
+            lw = std::max(lw / 2, 1);
+            lh = std::max(lh / 2, 1);
+            total += size_t(lw) * lh * c;
+        }
+        image.pixels.resize(total);
+
+        size_t srcOffset = 0;
+        for (int level = 1; level < levels; level++)
+        {
+            const int nw = std::max(w / 2, 1), nh = std::max(h / 2, 1);
+            const unsigned char *src = image.pixels.data() + srcOffset;
+            unsigned char *dst = image.pixels.data() + srcOffset + size_t(w) * h * c;
+            for (int y = 0; y < nh; y++)
+            {
+                const int y0 = std::min(y * 2, h - 1), y1 = std::min(y * 2 + 1, h - 1);
+                for (int x = 0; x < nw; x++)
+                {
+                    const int x0 = std::min(x * 2, w - 1), x1 = std::min(x * 2 + 1, w - 1);
+                    for (int k = 0; k < c; k++)
+                    {
+                        int sum = src[(size_t(y0) * w + x0) * c + k] + src[(size_t(y0) * w + x1) * c + k] +
+                                  src[(size_t(y1) * w + x0) * c + k] + src[(size_t(y1) * w + x1) * c + k];
+                        dst[(size_t(y) * nw + x) * c + k] = static_cast<unsigned char>((sum + 2) / 4);
+                    }
+                }
+            }
+            srcOffset += size_t(w) * h * c;
+            w = nw;
+            h = nh;
+        }
+        image.levels = levels;
+    }
+
+    bool waiting(const Image &image) const
+    {
+        auto job = jobs.find(image.textureID);
+        return job != jobs.end() && job->second == image.job;
+    }
+
+    // the next decoded image whose texture still waits for it
+    std::unique_ptr<Image> next()
+    {
+        std::lock_guard<std::mutex> lock(ready->mutex);
+        while (!ready->images.empty())
+        {
+            std::unique_ptr<Image> image = std::move(ready->images.front());
+            ready->images.pop_front();
+            if (waiting(*image))
+                return image;
+        }
+        return nullptr;
+    }
+
+    // allocates every level of the texture and shows only the smallest one, which is the placeholder until the
+    // real levels are in; false if the image failed to load
+    bool begin(Image &image)
+    {
+        if (image.pixels.empty())
+        {
+            std::cout << "Texture failed to load at path: " << image.filename << std::endl;
+            return false;
+        }
+
+        image.format = GL_RGBA;
+        if (image.components == 1)
+            image.format = GL_RED;
+        else if (image.components == 3)
+            image.format = GL_RGB;
+        image.internalFormat = image.format;
+        if (image.gamma && image.format == GL_RGB)
+            image.internalFormat = GL_SRGB;
+        else if (image.gamma && image.format == GL_RGBA)
+            image.internalFormat = GL_SRGB_ALPHA;
+
+        int levels = 1;
+        while (std::max(image.width, image.height) >> levels)
+            levels++;
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        glBindTexture(GL_TEXTURE_2D, image.textureID);
+        size_t offset = 0;
+        for (int level = 0; level < levels; level++)
+        {
+            const int w = std::max(image.width >> level, 1), h = std::max(image.height >> level, 1);
+            glTexImage2D(GL_TEXTURE_2D, level, image.internalFormat, w, h, 0, image.format, GL_UNSIGNED_BYTE, nullptr);
+            image.offsets.push_back(offset);
+            offset += size_t(w) * h * image.components;
+        }
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, levels - 1);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels - 1);
+        if (image.levels > 0)
+            image.level = levels - 1;
+        else
+        {
+            // only the full size level comes from the image; the rest is generated at the end
+            glTexSubImage2D(GL_TEXTURE_2D, levels - 1, 0, 0, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, &image.placeholder);
+            image.level = 0;
+        }
+        image.row = 0;
+        return true;
+    }
+
+    // uploads rows of the current level, at least one and no more than byteBudget bytes unless a single row is
+    // larger; returns the bytes uploaded
+    size_t stream(Image &image, size_t byteBudget)
+    {
+        const int w = std::max(image.width >> image.level, 1), h = std::max(image.height >> image.level, 1);
+        const size_t rowSize = size_t(w) * image.components;
+        const int rows = static_cast<int>(std::min<size_t>(std::max<size_t>(byteBudget / rowSize, 1), size_t(h - image.row)));
+        const size_t size = rowSize * rows;
+        const unsigned char *source = image.pixels.data() + image.offsets[image.level] + rowSize * image.row;
+
+        if (!pbo)
+            glGenBuffers(1, &pbo);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo);
+        // orphan the previous storage so we never wait on an upload that is still in flight
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, size, nullptr, GL_STREAM_DRAW);
+        void *mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+        if (mapped)
+        {
+            memcpy(mapped, source, size);
+            glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+        }
+        else
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+        GLint alignment;
+        glGetIntegerv(GL_UNPACK_ALIGNMENT, &alignment);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glBindTexture(GL_TEXTURE_2D, image.textureID);
+        glTexSubImage2D(GL_TEXTURE_2D, image.level, 0, image.row, w, rows, image.format, GL_UNSIGNED_BYTE, mapped ? nullptr : source);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, alignment);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+        image.row += rows;
+        if (image.row == h)
+        {
+            // the level is complete: sample from it from now on
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, image.level);
+            if (image.levels == 0)
+                glGenerateMipmap(GL_TEXTURE_2D);
+            image.level = image.levels > 0 ? image.level - 1 : -1;
+            image.row = 0;
+        }
+        return size;
+    }
+
+    std::shared_ptr<Queue> ready; // shared with in-flight decode jobs, which may finish after the loader is gone
+    std::unordered_map<unsigned int, unsigned int> jobs; // texture -> job of the image it waits for
+    std::unique_ptr<Image> current;                      // the image being streamed in
+    unsigned int lastJob = 0;
+    unsigned int pbo = 0;
+};
+#endif
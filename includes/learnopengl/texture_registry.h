@@ -0,0 +1,97 @@
+#ifndef TEXTURE_REGISTRY_H
+#define TEXTURE_REGISTRY_H
+
+#include <glad/glad.h>
+
+#include <learnopengl/texture_loader.h>
+
+#include <cstdlib>
+#include <string>
+#include <unordered_map>
+
+// Process-wide, reference counted table of loaded textures so models that share texture files share one GL
+// texture and one decode. Entries are keyed by the canonical absolute path plus the load flags (gamma etc.).
+// Only use it from the thread that owns the GL context.
+class TextureRegistry
+{
+public:
+    enum Flags
+    {
+        SRGB               = 1 << 0,
+        ASYNC              = 1 << 1, // streamed through AsyncTextureLoader
+        PLACEHOLDER_NORMAL = 1 << 2  // async, showing a flat normal rather than white until the image is in
+    };
+
+    static TextureRegistry& instance()
+    {
+        static TextureRegistry registry;
+        return registry;
+    }
+
+    // returns the texture for filename, calling load() to create it if it isn't registered yet.
+    // Every acquire must be matched with a release.
+    template<typename Load>
+    unsigned int acquire(const std::string &filename, unsigned int flags, Load load)
+    {
+        std::string key = canonicalPath(filename) + '|' + std::to_string(flags);
+        auto it = entries.find(key);
+        if (it != entries.end())
+        {
+            it->second.refs++;
+            return it->second.id;
+        }
+        unsigned int id = load();
+        entries[key] = Entry{ id, 1, flags };
+        keys[id] = key;
+        return id;
+    }
+
+    // drops a reference; the GL texture is deleted once nobody uses it anymore
+    void release(unsigned int id)
+    {
+        auto key = keys.find(id);
+        if (key == keys.end())
+            return;
+        auto entry = entries.find(key->second);
+        if (--entry->second.refs == 0)
+        {
+            // an image still being streamed in must not be uploaded to the deleted (and maybe reused) name
+            if (entry->second.flags & ASYNC)
+                AsyncTextureLoader::instance().cancel(id);
+            glDeleteTextures(1, &id);
+            entries.erase(entry);
+            keys.erase(key);
+        }
+    }
+
+    size_t size() const { return entries.size(); }
+
+    static std::string canonicalPath(const std::string &path)
+    {
+#ifdef _WIN32
+        char buffer[_MAX_PATH];
+        if (_fullpath(buffer, path.c_str(), _MAX_PATH))
+            return buffer;
+#else
+        if (char *resolved = realpath(path.c_str(), nullptr))
+        {
+            std::string result(resolved);
+            free(resolved);
+            return result;
+        }
+#endif
+        return path;
+    }
+
+private:
+    struct Entry
+    {
+        unsigned int id;
+        unsigned int refs;
+        unsigned int flags;
+    };
+
+    std::unordered_map<std::string, Entry> entries;
+    std::unordered_map<unsigned int, std::string> keys;
+};
+#endif
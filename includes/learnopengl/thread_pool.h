@@ -0,0 +1,135 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// A small fixed-size pool of worker threads. submit() queues fire-and-forget jobs, parallelFor()
+// splits an index range over the workers and blocks until every index has been processed.
+// Jobs must not touch OpenGL; that stays on the thread owning the context.
+class ThreadPool
+{
+public:
+    explicit ThreadPool(unsigned int threadCount = defaultThreadCount())
+    {
+        for (unsigned int i = 0; i < threadCount; i++)
+            workers.emplace_back([this] { workerLoop(); });
+    }
+
+    ~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wakeup.notify_all();
+        for (std::thread& worker : workers)
+            worker.join();
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // the pool shared by the learnopengl helpers, created on first use
+    static ThreadPool& shared()
+    {
+        static ThreadPool pool;
+        return pool;
+    }
+
+    static unsigned int defaultThreadCount()
+    {
+        unsigned int count = std::thread::hardware_concurrency();
+        return count > 1 ? count - 1 : 1; // leave a core for the render thread
+    }
+
+    unsigned int size() const { return static_cast<unsigned int>(workers.size()); }
+
+    void submit(std::function<void()> job)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            jobs.push_back(std::move(job));
+        }
+        wakeup.notify_one();
+    }
+
+    // calls fn(i) for every i in [0, count). The calling thread takes part in the work, so this is
+    // safe to call from inside a job as well.
+    template<typename Fn>
+    void parallelFor(size_t count, Fn fn)
+    {
+        if (count == 0)
+            return;
+        if (count == 1 || workers.empty())
+        {
+            for (size_t i = 0; i < count; i++)
+                fn(i);
+            return;
+        }
+
+        struct Range
+        {
+            std::atomic<size_t> next{ 0 };
+            std::atomic<size_t> done{ 0 };
+            std::mutex mutex;
+            std::condition_variable finished;
+        };
+        auto range = std::make_shared<Range>();
+        auto work = [range, count, &fn]
+        {
+            size_t completed = 0;
+            for (size_t i = range->next++; i < count; i = range->next++)
+            {
+                fn(i);
+                completed++;
+            }
+            if (completed && range->done.fetch_add(completed) + completed == count)
+            {
+                std::lock_guard<std::mutex> lock(range->mutex);
+                range->finished.notify_all();
+            }
+        };
+
+        size_t helpers = std::min<size_t>(workers.size(), count - 1);
+        for (size_t i = 0; i < helpers; i++)
+            submit(work);
+        work();
+
+        // helpers that start after the range is drained return without touching fn
+        std::unique_lock<std::mutex> lock(range->mutex);
+        range->finished.wait(lock, [&] { return range->done.load() == count; });
+    }
+
+private:
+    void workerLoop()
+    {
+        for (;;)
+        {
+            std::function<void()> job;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wakeup.wait(lock, [this] { return stopping || !jobs.empty(); });
+                if (stopping && jobs.empty())
+                    return;
+                job = std::move(jobs.front());
+                jobs.pop_front();
+            }
+            job();
+        }
+    }
+
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> jobs;
+    std::mutex mutex;
+    std::condition_variable wakeup;
+    bool stopping = false;
+};
+#endif
@@ -0,0 +1,90 @@
+#ifndef TRANSPARENT_QUEUE_H
+#define TRANSPARENT_QUEUE_H
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+// Back-to-front ordering for transparent draws. Every frame: clear(), push() each object with its view distance,
+// sort(), then draw items() in order (furthest first). Each entry carries a 32-bit depth key plus the caller's
+// object id; the LSD radix sort is stable, so objects at exactly the same distance keep their push order instead of
+// overwriting each other. Both buffers are kept between frames, so a warmed up queue doesn't allocate.
+class TransparentQueue
+{
+public:
+    struct Item
+    {
+        uint32_t depthKey;
+        uint32_t id;
+    };
+
+    void reserve(size_t count)
+    {
+        queue.reserve(count);
+        scratch.reserve(count);
+    }
+
+    void clear() { queue.clear(); }
+
+    // any value that grows with the distance to the camera works, e.g. the squared distance (no sqrt needed)
+    void push(float distance, uint32_t id)
+    {
+        queue.push_back(Item{ ~sortableKey(distance), id }); // inverted: the furthest object gets the smallest key
+    }
+
+    void sort()
+    {
+        const size_t count = queue.size();
+        scratch.resize(count);
+
+        // one read for all four byte histograms
+        uint32_t histograms[4][256];
+        memset(histograms, 0, sizeof(histograms));
+        for (const Item &item : queue)
+        {
+            histograms[0][item.depthKey & 0xFF]++;
+            histograms[1][(item.depthKey >> 8) & 0xFF]++;
+            histograms[2][(item.depthKey >> 16) & 0xFF]++;
+            histograms[3][item.depthKey >> 24]++;
+        }
+
+        for (int pass = 0; pass < 4; pass++)
+        {
+            uint32_t *histogram = histograms[pass];
+            const unsigned int shift = pass * 8;
+            // skip passes where every key has the same byte (typical for the top byte of nearby distances)
+            if (count == 0 || histogram[(queue[0].depthKey >> shift) & 0xFF] == count)
+                continue;
+
+            uint32_t offset = 0;
+            for (int bucket = 0; bucket < 256; bucket++)
+            {
+                uint32_t size = histogram[bucket];
+                histogram[bucket] = offset;
+                offset += size;
+            }
+            for (const Item &item : queue)
+                scratch[histogram[(item.depthKey >> shift) & 0xFF]++] = item;
+            queue.swap(scratch);
+        }
+    }
+
+    const std::vector<Item>& items() const { return queue; }
+    size_t size() const { return queue.size(); }
+
+    // maps a float onto an unsigned int with the same ordering (negative values included)
+    static uint32_t sortableKey(float value)
+    {
+        uint32_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        return (bits & 0x80000000u) ? ~bits : bits | 0x80000000u;
+    }
+
+private:
+    std::vector<Item> queue;
+    std::vector<Item> scratch;
+};
+#endif
@@ -0,0 +1,143 @@
+#ifndef UNIFORM_H
+#define UNIFORM_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// A uniform location resolved once, so hot loops can set a uniform without building a name string or asking the
+// driver. Like the Shader::setXXX functions it writes to the currently bound program.
+template<typename T>
+struct UniformHandle
+{
+    GLint location = -1;
+
+    bool valid() const { return location >= 0; }
+    void set(const T &value) const;
+};
+
+template<> inline void UniformHandle<bool>::set(const bool &value) const { glUniform1i(location, (int)value); }
+template<> inline void UniformHandle<int>::set(const int &value) const { glUniform1i(location, value); }
+template<> inline void UniformHandle<float>::set(const float &value) const { glUniform1f(location, value); }
+template<> inline void UniformHandle<glm::vec2>::set(const glm::vec2 &value) const { glUniform2fv(location, 1, &value[0]); }
+template<> inline void UniformHandle<glm::vec3>::set(const glm::vec3 &value) const { glUniform3fv(location, 1, &value[0]); }
+template<> inline void UniformHandle<glm::vec4>::set(const glm::vec4 &value) const { glUniform4fv(location, 1, &value[0]); }
+template<> inline void UniformHandle<glm::mat2>::set(const glm::mat2 &mat) const { glUniformMatrix2fv(location, 1, GL_FALSE, &mat[0][0]); }
+template<> inline void UniformHandle<glm::mat3>::set(const glm::mat3 &mat) const { glUniformMatrix3fv(location, 1, GL_FALSE, &mat[0][0]); }
+template<> inline void UniformHandle<glm::mat4>::set(const glm::mat4 &mat) const { glUniformMatrix4fv(location, 1, GL_FALSE, &mat[0][0]); }
+
+// Every active uniform of a linked program, enumerated once into an open addressing hash table. Array uniforms are
+// registered under their base name as well as under each "name[i]" element. Unknown names map to -1, which GL
+// ignores, just like glGetUniformLocation does for inactive uniforms.
+class UniformTable
+{
+public:
+    void build(GLuint program)
+    {
+        slots.clear();
+        names.clear();
+        count = 0;
+        GLint activeUniforms = 0, maxLength = 0;
+        glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &activeUniforms);
+        glGetProgramiv(program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+
+        std::vector<std::pair<std::string, GLint>> found;
+        std::vector<char> buffer(maxLength + 1);
+        for (GLint i = 0; i < activeUniforms; i++)
+        {
+            GLsizei length = 0;
+            GLint size = 0;
+            GLenum type;
+            glGetActiveUniform(program, i, maxLength, &length, &size, &type, buffer.data());
+            std::string name(buffer.data(), length);
+            GLint location = glGetUniformLocation(program, name.c_str());
+            if (location < 0)
+                continue; // members of uniform blocks have no location
+            found.emplace_back(name, location);
+
+            // arrays of basic types are reported once as "name[0]"
+            const size_t suffix = name.size() >= 3 ? name.size() - 3 : 0;
+            if (name.compare(suffix, 3, "[0]") == 0)
+            {
+                std::string base = name.substr(0, suffix);
+                found.emplace_back(base, location);
+                for (GLint element = 1; element < size; element++)
+                {
+                    std::string elementName = base + '[' + std::to_string(element) + ']';
+                    found.emplace_back(elementName, glGetUniformLocation(program, elementName.c_str()));
+                }
+            }
+        }
+
+        size_t capacity = 16;
+        while (capacity < found.size() * 2)
+            capacity *= 2;
+        slots.assign(capacity, Slot());
+        for (const auto &uniform : found)
+            insert(uniform.first, uniform.second);
+    }
+
+    GLint location(const char *name) const
+    {
+        if (slots.empty())
+            return -1;
+        const uint32_t hash = hashName(name);
+        const size_t mask = slots.size() - 1;
+        for (size_t i = hash & mask; ; i = (i + 1) & mask)
+        {
+            const Slot &slot = slots[i];
+            if (slot.location == EMPTY)
+                return -1;
+            if (slot.hash == hash && std::strcmp(&names[slot.nameOffset], name) == 0)
+                return slot.location;
+        }
+    }
+
+    size_t size() const { return count; }
+
+private:
+    static const GLint EMPTY = -2;
+
+    struct Slot
+    {
+        uint32_t hash = 0;
+        GLint location = EMPTY;
+        uint32_t nameOffset = 0;
+    };
+
+    static uint32_t hashName(const char *name)
+    {
+        uint32_t hash = 2166136261u; // 32-bit FNV-1a
+        for (; *name; name++)
+        {
+            hash ^= static_cast<unsigned char>(*name);
+            hash *= 16777619u;
+        }
+        return hash;
+    }
+
+    void insert(const std::string &name, GLint location)
+    {
+        if (location < 0 || this->location(name.c_str()) >= 0)
+            return;
+        const uint32_t hash = hashName(name.c_str());
+        const size_t mask = slots.size() - 1;
+        size_t i = hash & mask;
+        while (slots[i].location != EMPTY)
+            i = (i + 1) & mask;
+        slots[i].hash = hash;
+        slots[i].location = location;
+        slots[i].nameOffset = static_cast<uint32_t>(names.size());
+        names.insert(names.end(), name.c_str(), name.c_str() + name.size() + 1);
+        count++;
+    }
+
+    std::vector<Slot> slots;
+    std::vector<char> names; // all names, '\0' separated
+    size_t count = 0;
+};
+#endif
@@ -0,0 +1,155 @@
+#ifndef VERTEX_FORMAT_H
+#define VERTEX_FORMAT_H
+
+#include <glm/glm.hpp>
+#include <glm/gtc/packing.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#define MAX_BONE_INFLUENCE 4
+
+// the vertex as it comes out of the importer; also the full GPU layout
+struct Vertex {
+    // position
+    glm::vec3 Position;
+    // normal
+    glm::vec3 Normal;
+    // texCoords
+    glm::vec2 TexCoords;
+    // tangent
+    glm::vec3 Tangent;
+    // bitangent
+    glm::vec3 Bitangent;
+	//bone indexes which will influence this vertex
+	int m_BoneIDs[MAX_BONE_INFLUENCE];
+	//weights from each bone
+	float m_Weights[MAX_BONE_INFLUENCE];
+};
+
+// Compact GPU layouts. The tangent frame is two octahedral directions in four normalized shorts, read by the shader
+// as one vec4 at location 1: xy is the normal, zw the tangent, the sign of w is the sign of the bitangent (see
+// VertexPacking::unpackFrame for the decoding the shader has to mirror). Texture coordinates are half floats at
+// location 2, which the shader still reads as a vec2.
+struct StaticVertex {
+    glm::vec3 Position;
+    int16_t   Frame[4];
+    uint16_t  TexCoords[2];
+};
+
+// plus up to 4 bone ids (location 5, ivec4) and weights (location 6, vec4 adding up to 1). Unused influences have
+// bone 0 and weight 0
+struct SkinnedVertex {
+    glm::vec3 Position;
+    int16_t   Frame[4];
+    uint16_t  TexCoords[2];
+    uint8_t   BoneIDs[MAX_BONE_INFLUENCE];
+    uint16_t  Weights[MAX_BONE_INFLUENCE];
+};
+
+// which of the above a mesh uploaded
+enum class VertexLayout { FULL, STATIC, SKINNED };
+
+inline size_t vertexStride(VertexLayout layout)
+{
+    return layout == VertexLayout::STATIC ? sizeof(StaticVertex) : layout == VertexLayout::SKINNED ? sizeof(SkinnedVertex) : sizeof(Vertex);
+}
+
+namespace VertexPacking
+{
+    // unit vector -> point in [-1, 1]^2: the octahedron |x| + |y| + |z| = 1 with its lower half folded out over the corners
+    inline glm::vec2 octEncode(const glm::vec3& n)
+    {
+        const float length = std::abs(n.x) + std::abs(n.y) + std::abs(n.z);
+        if (length == 0.0f)
+            return glm::vec2(0.0f);
+        glm::vec2 p = glm::vec2(n.x, n.y) / length;
+        if (n.z < 0.0f)
+            p = glm::vec2((1.0f - std::abs(p.y)) * (p.x >= 0.0f ? 1.0f : -1.0f), (1.0f - std::abs(p.x)) * (p.y >= 0.0f ? 1.0f : -1.0f));
+        return p;
+    }
+
+    inline glm::vec3 octDecode(const glm::vec2& p)
+    {
+        glm::vec3 n(p.x, p.y, 1.0f - std::abs(p.x) - std::abs(p.y));
+        const float fold = std::max(-n.z, 0.0f);
+        n.x += n.x >= 0.0f ? -fold : fold;
+        n.y += n.y >= 0.0f ? -fold : fold;
+        return glm::normalize(n);
+    }
+
+    // The tangent's second coordinate is moved to [0, 1] so its sign is free for the bitangent, and it never becomes 0
+    // so the sign survives. The bitangent is rebuilt as cross(normal, tangent) * sign
+    inline void packFrame(const glm::vec3& normal, const glm::vec3& tangent, const glm::vec3& bitangent, int16_t frame[4])
+    {
+        const glm::vec2 n = octEncode(normal), t = octEncode(tangent);
+        const float sign = glm::dot(glm::cross(normal, tangent), bitangent) < 0.0f ? -1.0f : 1.0f;
+        frame[0] = (int16_t)glm::packSnorm1x16(n.x);
+        frame[1] = (int16_t)glm::packSnorm1x16(n.y);
+        frame[2] = (int16_t)glm::packSnorm1x16(t.x);
+        frame[3] = (int16_t)(sign * std::max(std::round((t.y * 0.5f + 0.5f) * 32767.0f), 1.0f));
+    }
+
+    inline void unpackFrame(const int16_t frame[4], glm::vec3& normal, glm::vec3& tangent, glm::vec3& bitangent)
+    {
+        const glm::vec4 f = glm::vec4(frame[0], frame[1], frame[2], frame[3]) / 32767.0f;
+        normal = octDecode(glm::vec2(f.x, f.y));
+        tangent = octDecode(glm::vec2(f.z, std::abs(f.w) * 2.0f - 1.0f));
+        bitangent = glm::cross(normal, tangent) * (f.w < 0.0f ? -1.0f : 1.0f);
+    }
+
+    inline StaticVertex packStatic(const Vertex& vertex)
+    {
+        StaticVertex out;
+        out.Position = vertex.Position;
+        packFrame(vertex.Normal, vertex.Tangent, vertex.Bitangent, out.Frame);
+        out.TexCoords[0] = glm::packHalf1x16(vertex.TexCoords.x);
+        out.TexCoords[1] = glm::packHalf1x16(vertex.TexCoords.y);
+        return out;
+    }
+
+    // the weights are rounded so that they still add up to exactly 1: what rounding gets wrong goes to the largest one
+    inline SkinnedVertex packSkinned(const Vertex& vertex)
+    {
+        SkinnedVertex out;
+        out.Position = vertex.Position;
+        packFrame(vertex.Normal, vertex.Tangent, vertex.Bitangent, out.Frame);
+        out.TexCoords[0] = glm::packHalf1x16(vertex.TexCoords.x);
+        out.TexCoords[1] = glm::packHalf1x16(vertex.TexCoords.y);
+
+        float total = 0.0f;
+        for (int i = 0; i < MAX_BONE_INFLUENCE; i++)
+            total += vertex.m_BoneIDs[i] >= 0 ? vertex.m_Weights[i] : 0.0f;
+        int sum = 0, largest = 0;
+        for (int i = 0; i < MAX_BONE_INFLUENCE; i++)
+        {
+            const bool used = vertex.m_BoneIDs[i] >= 0 && total > 0.0f;
+            out.BoneIDs[i] = used ? (uint8_t)vertex.m_BoneIDs[i] : 0;
+            out.Weights[i] = used ? glm::packUnorm1x16(vertex.m_Weights[i] / total) : 0;
+            sum += out.Weights[i];
+            largest = out.Weights[i] > out.Weights[largest] ? i : largest;
+        }
+        if (sum > 0)
+            out.Weights[largest] = (uint16_t)(out.Weights[largest] + 65535 - sum);
+        return out;
+    }
+
+    // the bone ids of a skinned vertex are bytes
+    inline bool fitsSkinned(const Vertex& vertex)
+    {
+        for (int i = 0; i < MAX_BONE_INFLUENCE; i++)
+            if (vertex.m_BoneIDs[i] > 255)
+                return false;
+        return true;
+    }
+
+    inline bool isSkinned(const Vertex& vertex)
+    {
+        for (int i = 0; i < MAX_BONE_INFLUENCE; i++)
+            if (vertex.m_BoneIDs[i] >= 0 && vertex.m_Weights[i] > 0.0f)
+                return true;
+        return false;
+    }
+}
+#endif
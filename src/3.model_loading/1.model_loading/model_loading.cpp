@@ -85,7 +85,15 @@ int main()
     auto path = getenv("model");
     if (!path) path = "resources/objects/backpack/backpack.obj";
     printf("model %s\n", path);
-    Model ourModel(FileSystem::getPath(path));
+    bool asyncTextures = getenv("async_textures") != nullptr;
+    double loadStart = glfwGetTime();
+    Model ourModel(FileSystem::getPath(path), false, asyncTextures);
+    printf("model loaded in %.1f ms\n", (glfwGetTime() - loadStart) * 1000.0);
+    if (getenv("load_only"))
+    {
+        glfwTerminate();
+        return 0;
+    }
 
     
     // draw in wireframe
@@ -93,6 +101,10 @@ int main()
 
     // render loop
     // -----------
+    bool firstFrame = true;
+    bool streaming = asyncTextures;
+    float worstFrame = 0.0f;
+    lastFrame = static_cast<float>(glfwGetTime());
     while (!glfwWindowShouldClose(window))
     {
         // per-frame time logic
@@ -100,6 +112,17 @@ int main()
         float currentFrame = static_cast<float>(glfwGetTime());
         deltaTime = currentFrame - lastFrame;
         lastFrame = currentFrame;
+        if (streaming)
+        {
+            // stream decoded textures in under a per-frame upload budget and report the worst frame meanwhile
+            worstFrame = std::max(worstFrame, deltaTime);
+            AsyncTextureLoader::instance().update(8 * 1024 * 1024);
+            if (AsyncTextureLoader::instance().pendingCount() == 0)
+            {
+                printf("textures streamed in after %.1f ms, worst frame %.1f ms\n", (glfwGetTime() - loadStart) * 1000.0, worstFrame * 1000.0f);
+                streaming = false;
+            }
+        }
 
         // input
         // -----
@@ -131,6 +154,11 @@ int main()
         // -------------------------------------------------------------------------------
         glfwSwapBuffers(window);
         glfwPollEvents();
+        if (firstFrame)
+        {
+            printf("first frame after %.1f ms\n", (glfwGetTime() - loadStart) * 1000.0);
+            firstFrame = false;
+        }
     }
 
     // glfw: terminate, clearing all previously allocated GLFW resources.
@@ -80,8 +80,9 @@ int main()
 
     // load models
     // -----------
-    Model rock(FileSystem::getPath("resources/objects/rock/rock.obj"));
-    Model planet(FileSystem::getPath("resources/objects/planet/planet.obj"));
+    // the shaders only read positions and texture coords, so the compact vertex layout works as is
+    Model rock(FileSystem::getPath("resources/objects/rock/rock.obj"), false, false, true);
+    Model planet(FileSystem::getPath("resources/objects/planet/planet.obj"), false, false, true);
 
     // generate a large list of semi-random model transformation matrices
     // ------------------------------------------------------------------
@@ -11,7 +11,11 @@
 #include <learnopengl/camera.h>
 #include <learnopengl/model.h>
 
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
 #include <iostream>
+#include <vector>
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
@@ -81,8 +85,26 @@ int main()
 
     // load models
     // -----------
-    Model rock(FileSystem::getPath("resources/objects/rock/rock.obj"));
-    Model planet(FileSystem::getPath("resources/objects/planet/planet.obj"));
+    // the shaders only read positions and texture coords, so the compact vertex layout works as is
+    Model rock(FileSystem::getPath("resources/objects/rock/rock.obj"), false, false, true);
+    Model planet(FileSystem::getPath("resources/objects/planet/planet.obj"), false, false, true);
+    size_t fullSize = 0;
+    for (const Mesh& mesh : rock.meshes)
+        fullSize += mesh.vertices.size() * sizeof(Vertex);
+    std::cout << "rock vertex buffers: " << rock.vertexBufferSize() << " bytes (" << fullSize << " with the full layout)" << std::endl;
+
+    // simplified rocks for the distance, picked per rock so that the simplification covers at most lod_pixels pixels
+    // on screen (1 by default, lod_pixels=0 always draws the full rock)
+    rock.generateLods(4);
+    const char* lodPixelsEnv = getenv("lod_pixels");
+    const float lodPixels = lodPixelsEnv ? static_cast<float>(atof(lodPixelsEnv)) : 1.0f;
+    const int lodCount = rock.lodCount();
+    std::vector<float> lodErrors(lodCount);
+    for (int lod = 0; lod < lodCount; lod++)
+    {
+        lodErrors[lod] = rock.lodError(lod);
+        printf("rock lod %d: %u triangles, error %g\n", lod, rock.meshes[0].lods[lod].count / 3, lodErrors[lod]);
+    }
 
     // generate a large list of semi-random model transformation matrices
     // ------------------------------------------------------------------
@@ -119,10 +141,19 @@ int main()
 
     // configure instanced array
     // -------------------------
+    // refilled every frame with the matrices sorted by level of detail, one instanced draw per level
     unsigned int buffer;
     glGenBuffers(1, &buffer);
     glBindBuffer(GL_ARRAY_BUFFER, buffer);
-    glBufferData(GL_ARRAY_BUFFER, amount * sizeof(glm::mat4), &modelMatrices[0], GL_STATIC_DRAW);
+    glBufferData(GL_ARRAY_BUFFER, amount * sizeof(glm::mat4), &modelMatrices[0], GL_STREAM_DRAW);
+    std::vector<float> rockScales(amount);
+    for (unsigned int i = 0; i < amount; i++)
+        rockScales[i] = glm::length(glm::vec3(modelMatrices[i][0]));
+    std::vector<unsigned char> rockLods(amount);
+    std::vector<glm::mat4> sortedMatrices(amount);
+    std::vector<unsigned int> lodStart(lodCount + 1), lodNext(lodCount);
+    double frameSeconds = 0.0, reportTime = glfwGetTime();
+    int reportFrames = 0;
 
     // set transformation matrices as an instance vertex attribute (with divisor 1)
     // note: we're cheating a little by taking the, now publicly declared, VAO of the model's mesh(es) and adding new vertexAttribPointers
@@ -191,13 +222,57 @@ int main()
         asteroidShader.setInt("texture_diffuse1", 0);
         glActiveTexture(GL_TEXTURE0);
         glBindTexture(GL_TEXTURE_2D, rock.textures_loaded[0].id); // note: we also made the textures_loaded vector public (instead of private) from the model class.
+        // pick a level per rock from its distance and size on screen, then bucket the matrices by level
+        const float pixelsPerUnit = SCR_HEIGHT / (2.0f * tan(glm::radians(45.0f) * 0.5f));
+        std::fill(lodStart.begin(), lodStart.end(), 0u);
+        for (unsigned int i = 0; i < amount; i++)
+        {
+            const float distance = glm::length(glm::vec3(modelMatrices[i][3]) - camera.Position);
+            rockLods[i] = static_cast<unsigned char>(MeshSimplifier::selectLevel(lodErrors.data(), lodCount, rockScales[i], distance, pixelsPerUnit, lodPixels));
+            lodStart[rockLods[i] + 1]++;
+        }
+        for (int lod = 0; lod < lodCount; lod++)
+            lodStart[lod + 1] += lodStart[lod];
+        lodNext.assign(lodStart.begin(), lodStart.end() - 1);
+        for (unsigned int i = 0; i < amount; i++)
+            sortedMatrices[lodNext[rockLods[i]]++] = modelMatrices[i];
+        glBindBuffer(GL_ARRAY_BUFFER, buffer);
+        glBufferData(GL_ARRAY_BUFFER, amount * sizeof(glm::mat4), nullptr, GL_STREAM_DRAW); // orphan last frame's data
+        glBufferSubData(GL_ARRAY_BUFFER, 0, amount * sizeof(glm::mat4), sortedMatrices.data());
+
+        size_t triangles = 0;
         for (unsigned int i = 0; i < rock.meshes.size(); i++)
         {
-            glBindVertexArray(rock.meshes[i].VAO);
-            glDrawElementsInstanced(GL_TRIANGLES, static_cast<unsigned int>(rock.meshes[i].indices.size()), GL_UNSIGNED_INT, 0, amount);
+            const Mesh& mesh = rock.meshes[i];
+            glBindVertexArray(mesh.VAO);
+            for (int lod = 0; lod < lodCount; lod++)
+            {
+                const unsigned int count = lodStart[lod + 1] - lodStart[lod];
+                if (count == 0)
+                    continue;
+                // the instance attributes start at the level's first matrix (no base instance in GL 3.3)
+                const size_t first = lodStart[lod] * sizeof(glm::mat4);
+                for (int column = 0; column < 4; column++)
+                    glVertexAttribPointer(3 + column, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)(first + column * sizeof(glm::vec4)));
+                glDrawElementsInstanced(GL_TRIANGLES, mesh.lods[lod].count, mesh.indexType, mesh.lodOffset(lod), count);
+                triangles += size_t(mesh.lods[lod].count / 3) * count;
+            }
             glBindVertexArray(0);
         }
 
+        // average frame time and how the rocks spread over the levels, every five seconds
+        frameSeconds += deltaTime;
+        if (++reportFrames, currentFrame - reportTime >= 5.0)
+        {
+            printf("%.2f ms per frame, %.1f M rock triangles, rocks per level:", frameSeconds / reportFrames * 1000.0, triangles / 1e6);
+            for (int lod = 0; lod < lodCount; lod++)
+                printf(" %u", lodStart[lod + 1] - lodStart[lod]);
+            printf("\n");
+            frameSeconds = 0.0;
+            reportFrames = 0;
+            reportTime = currentFrame;
+        }
+
         // glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
         // -------------------------------------------------------------------------------
         glfwSwapBuffers(window);
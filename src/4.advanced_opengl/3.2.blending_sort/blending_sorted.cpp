@@ -10,6 +10,7 @@
 #include <learnopengl/shader_m.h>
 #include <learnopengl/camera.h>
 #include <learnopengl/model.h>
+#include <learnopengl/transparent_queue.h>
 
 #include <iostream>
 
@@ -204,6 +205,10 @@ int main()
     shader.use();
     shader.setInt("texture1", 0);
 
+    // reused every frame so sorting doesn't allocate
+    TransparentQueue transparentQueue;
+    transparentQueue.reserve(windows.size());
+
     // render loop
     // -----------
     while (!glfwWindowShouldClose(window))
@@ -220,12 +225,13 @@ int main()
 
         // sort the transparent windows before rendering
         // ---------------------------------------------
-        std::map<float, glm::vec3> sorted;
+        transparentQueue.clear();
         for (unsigned int i = 0; i < windows.size(); i++)
         {
-            float distance = glm::length(camera.Position - windows[i]);
-            sorted[distance] = windows[i];
+            glm::vec3 offset = camera.Position - windows[i];
+            transparentQueue.push(glm::dot(offset, offset), i);
         }
+        transparentQueue.sort();
 
         // render
         // ------
@@ -259,10 +265,10 @@ int main()
         // windows (from furthest to nearest)
         glBindVertexArray(transparentVAO);
         glBindTexture(GL_TEXTURE_2D, transparentTexture);
-        for (std::map<float, glm::vec3>::reverse_iterator it = sorted.rbegin(); it != sorted.rend(); ++it)
+        for (const TransparentQueue::Item &item : transparentQueue.items())
         {
             model = glm::mat4(1.0f);
-            model = glm::translate(model, it->second);
+            model = glm::translate(model, windows[item.id]);
             shader.setMat4("model", model);
             glDrawArrays(GL_TRIANGLES, 0, 6);
         }
@@ -0,0 +1,66 @@
+#include <glm/glm.hpp>
+
+#include <learnopengl/transparent_queue.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <random>
+#include <vector>
+
+// CPU only comparison of the blending_sort sample's back to front ordering: the original std::map against
+// TransparentQueue. No window or GL context is created.
+
+void sortBenchmark(unsigned int count, unsigned int frames);
+
+int main()
+{
+    // number of windows, e.g. sort_bench=100000
+    const char *bench = getenv("sort_bench");
+    const int count = bench ? atoi(bench) : 100000;
+    sortBenchmark(count > 0 ? count : 1, 100);
+    return 0;
+}
+
+// sorts count random windows back to front for a number of frames, once per frame with a freshly built std::map
+// (the original approach) and once with a reused TransparentQueue, and prints the average time per frame.
+// ---------------------------------------------------------------------------------------------------------------
+void sortBenchmark(unsigned int count, unsigned int frames)
+{
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> coordinate(-100.0f, 100.0f);
+    std::vector<glm::vec3> positions(count);
+    for (glm::vec3 &position : positions)
+        position = glm::vec3(coordinate(rng), coordinate(rng), coordinate(rng));
+
+    using clock = std::chrono::steady_clock;
+    size_t mapKept = 0, queueKept = 0;
+    double mapTime = 0.0, queueTime = 0.0;
+    TransparentQueue transparentQueue;
+    for (unsigned int frame = 0; frame < frames; frame++)
+    {
+        glm::vec3 cameraPos(coordinate(rng), coordinate(rng), coordinate(rng));
+
+        auto start = clock::now();
+        std::map<float, glm::vec3> sorted;
+        for (unsigned int i = 0; i < count; i++)
+            sorted[glm::length(cameraPos - positions[i])] = positions[i];
+        mapTime += std::chrono::duration<double, std::milli>(clock::now() - start).count();
+        mapKept += sorted.size();
+
+        start = clock::now();
+        transparentQueue.clear();
+        for (unsigned int i = 0; i < count; i++)
+        {
+            glm::vec3 offset = cameraPos - positions[i];
+            transparentQueue.push(glm::dot(offset, offset), i);
+        }
+        transparentQueue.sort();
+        queueTime += std::chrono::duration<double, std::milli>(clock::now() - start).count();
+        queueKept += transparentQueue.size();
+    }
+    printf("%u objects, %u frames\n", count, frames);
+    printf("std::map:         %8.3f ms/frame, %zu objects dropped\n", mapTime / frames, size_t(count) * frames - mapKept);
+    printf("TransparentQueue: %8.3f ms/frame, %zu objects dropped\n", queueTime / frames, size_t(count) * frames - queueKept);
+}
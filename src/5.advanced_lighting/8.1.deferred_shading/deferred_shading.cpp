@@ -167,6 +167,21 @@ int main()
     shaderLightingPass.setInt("gPosition", 0);
     shaderLightingPass.setInt("gNormal", 1);
     shaderLightingPass.setInt("gAlbedoSpec", 2);
+    // resolve the per light uniforms once instead of building "lights[i].xxx" strings every frame
+    struct LightUniforms
+    {
+        UniformHandle<glm::vec3> position, color;
+        UniformHandle<float> linear, quadratic;
+    };
+    std::vector<LightUniforms> lightUniforms(NR_LIGHTS);
+    for (unsigned int i = 0; i < NR_LIGHTS; i++)
+    {
+        std::string light = "lights[" + std::to_string(i) + "]";
+        lightUniforms[i].position = shaderLightingPass.handle<glm::vec3>(light + ".Position");
+        lightUniforms[i].color = shaderLightingPass.handle<glm::vec3>(light + ".Color");
+        lightUniforms[i].linear = shaderLightingPass.handle<float>(light + ".Linear");
+        lightUniforms[i].quadratic = shaderLightingPass.handle<float>(light + ".Quadratic");
+    }
 
     // render loop
     // -----------
@@ -220,13 +235,13 @@ int main()
         // send light relevant uniforms
         for (unsigned int i = 0; i < lightPositions.size(); i++)
         {
-            shaderLightingPass.setVec3("lights[" + std::to_string(i) + "].Position", lightPositions[i]);
-            shaderLightingPass.setVec3("lights[" + std::to_string(i) + "].Color", lightColors[i]);
+            lightUniforms[i].position.set(lightPositions[i]);
+            lightUniforms[i].color.set(lightColors[i]);
             // update attenuation parameters and calculate radius
             const float linear = 0.7f;
             const float quadratic = 1.8f;
-            shaderLightingPass.setFloat("lights[" + std::to_string(i) + "].Linear", linear);
-            shaderLightingPass.setFloat("lights[" + std::to_string(i) + "].Quadratic", quadratic);
+            lightUniforms[i].linear.set(linear);
+            lightUniforms[i].quadratic.set(quadratic);
         }
         shaderLightingPass.setVec3("viewPos", camera.Position);
         // finally render quad
@@ -167,6 +167,22 @@ int main()
     shaderLightingPass.setInt("gPosition", 0);
     shaderLightingPass.setInt("gNormal", 1);
     shaderLightingPass.setInt("gAlbedoSpec", 2);
+    // resolve the per light uniforms once instead of building "lights[i].xxx" strings every frame
+    struct LightUniforms
+    {
+        UniformHandle<glm::vec3> position, color;
+        UniformHandle<float> linear, quadratic, radius;
+    };
+    std::vector<LightUniforms> lightUniforms(NR_LIGHTS);
+    for (unsigned int i = 0; i < NR_LIGHTS; i++)
+    {
+        std::string light = "lights[" + std::to_string(i) + "]";
+        lightUniforms[i].position = shaderLightingPass.handle<glm::vec3>(light + ".Position");
+        lightUniforms[i].color = shaderLightingPass.handle<glm::vec3>(light + ".Color");
+        lightUniforms[i].linear = shaderLightingPass.handle<float>(light + ".Linear");
+        lightUniforms[i].quadratic = shaderLightingPass.handle<float>(light + ".Quadratic");
+        lightUniforms[i].radius = shaderLightingPass.handle<float>(light + ".Radius");
+    }
 
     // render loop
     // -----------
@@ -220,18 +236,18 @@ int main()
         // send light relevant uniforms
         for (unsigned int i = 0; i < lightPositions.size(); i++)
         {
-            shaderLightingPass.setVec3("lights[" + std::to_string(i) + "].Position", lightPositions[i]);
-            shaderLightingPass.setVec3("lights[" + std::to_string(i) + "].Color", lightColors[i]);
+            lightUniforms[i].position.set(lightPositions[i]);
+            lightUniforms[i].color.set(lightColors[i]);
             // update attenuation parameters and calculate radius
             const float constant = 1.0f; // note that we don't send this to the shader, we assume it is always 1.0 (in our case)
             const float linear = 0.7f;
             const float quadratic = 1.8f;
-            shaderLightingPass.setFloat("lights[" + std::to_string(i) + "].Linear", linear);
-            shaderLightingPass.setFloat("lights[" + std::to_string(i) + "].Quadratic", quadratic);
+            lightUniforms[i].linear.set(linear);
+            lightUniforms[i].quadratic.set(quadratic);
             // then calculate radius of light volume/sphere
             const float maxBrightness = std::fmaxf(std::fmaxf(lightColors[i].r, lightColors[i].g), lightColors[i].b);
             float radius = (-linear + std::sqrt(linear * linear - 4 * quadratic * (constant - (256.0f / 5.0f) * maxBrightness))) / (2.0f * quadratic);
-            shaderLightingPass.setFloat("lights[" + std::to_string(i) + "].Radius", radius);
+            lightUniforms[i].radius.set(radius);
         }
         shaderLightingPass.setVec3("viewPos", camera.Position);
         // finally render quad
@@ -213,6 +213,11 @@ int main()
     shaderSSAO.setInt("gPosition", 0);
     shaderSSAO.setInt("gNormal", 1);
     shaderSSAO.setInt("texNoise", 2);
+    // resolve the kernel uniforms once instead of building "samples[i]" strings every frame
+    std::vector<UniformHandle<glm::vec3>> kernelUniforms;
+    for (unsigned int i = 0; i < 64; ++i)
+        kernelUniforms.push_back(shaderSSAO.handle<glm::vec3>("samples[" + std::to_string(i) + "]"));
+    UniformHandle<glm::mat4> ssaoProjection = shaderSSAO.handle<glm::mat4>("projection");
     shaderSSAOBlur.use();
     shaderSSAOBlur.setInt("ssaoInput", 0);
 
@@ -270,8 +275,8 @@ int main()
             shaderSSAO.use();
             // Send kernel + rotation 
             for (unsigned int i = 0; i < 64; ++i)
-                shaderSSAO.setVec3("samples[" + std::to_string(i) + "]", ssaoKernel[i]);
-            shaderSSAO.setMat4("projection", projection);
+                kernelUniforms[i].set(ssaoKernel[i]);
+            ssaoProjection.set(projection);
             glActiveTexture(GL_TEXTURE0);
             glBindTexture(GL_TEXTURE_2D, gPosition);
             glActiveTexture(GL_TEXTURE1);
@@ -7,6 +7,8 @@
 ** option) any later version.
 ******************************************************************/
 #include <algorithm>
+#include <chrono>
+#include <cstdlib>
 #include <sstream>
 #include <iostream>
 
@@ -35,6 +37,24 @@ ISoundEngine      *SoundEngine = createIrrKlangDevice();
 TextRenderer      *Text;
 
 float ShakeTime = 0.0f;
+// Stress tests: BREAKOUT_BRICKS=n replaces the first level with a random one of n bricks and BREAKOUT_PARTICLES=n keeps
+// about n particles alive behind the ball; both print what they cost every few seconds
+unsigned int StressBricks = 0;
+unsigned int StressParticles = 0;
+// averages the CPU time of something over a few seconds
+struct StressTimer
+{
+    double       Total = 0.0;
+    unsigned int Frames = 0;
+    std::chrono::steady_clock::time_point LastPrint = std::chrono::steady_clock::now();
+    // adds a frame's time in milliseconds; every five seconds returns true with the average
+    bool Add(double milliseconds, double &average);
+};
+StressTimer LevelTimer, ParticleTimer;
+double      ParticleUpdateTime = 0.0;
+// the lives counter as text, rebuilt when the number changes
+unsigned int ShownLives = ~0u;
+std::string  LivesText;
 
 
 Game::Game(unsigned int width, unsigned int height) 
@@ -45,13 +65,22 @@ Game::Game(unsigned int width, unsigned int height)
 
 Game::~Game()
 {
-    delete Renderer;
+    this->Clear();
     delete Player;
     delete Ball;
+    SoundEngine->drop();
+}
+
+void Game::Clear()
+{
+    delete Renderer;
     delete Particles;
     delete Effects;
     delete Text;
-    SoundEngine->drop();
+    Renderer = nullptr;
+    Particles = nullptr;
+    Effects = nullptr;
+    Text = nullptr;
 }
 
 void Game::Init()
@@ -81,7 +110,9 @@ void Game::Init()
     ResourceManager::LoadTexture(FileSystem::getPath("resources/textures/powerup_passthrough.png").c_str(), true, "powerup_passthrough");
     // set render-specific controls
     Renderer = new SpriteRenderer(ResourceManager::GetShader("sprite"));
-    Particles = new ParticleGenerator(ResourceManager::GetShader("particle"), ResourceManager::GetTexture("particle"), 500);
+    if (const char *particles = std::getenv("BREAKOUT_PARTICLES"))
+        StressParticles = std::max(std::atoi(particles), 0);
+    Particles = new ParticleGenerator(ResourceManager::GetShader("particle"), ResourceManager::GetTexture("particle"), StressParticles > 0 ? StressParticles : 500);
     Effects = new PostProcessor(ResourceManager::GetShader("postprocessing"), this->Width, this->Height);
     Text = new TextRenderer(this->Width, this->Height);
     Text->Load(FileSystem::getPath("resources/fonts/OCRAEXT.TTF").c_str(), 24);
@@ -95,6 +126,10 @@ void Game::Init()
     this->Levels.push_back(three);
     this->Levels.push_back(four);
     this->Level = 0;
+    if (const char *bricks = std::getenv("BREAKOUT_BRICKS"))
+        StressBricks = std::max(std::atoi(bricks), 0);
+    if (StressBricks > 0)
+        this->Levels[0].Generate(StressBricks, this->Width, this->Height / 2);
     // configure game objects
     glm::vec2 playerPos = glm::vec2(this->Width / 2.0f - PLAYER_SIZE.x / 2.0f, this->Height - PLAYER_SIZE.y);
     Player = new GameObject(playerPos, PLAYER_SIZE, ResourceManager::GetTexture("paddle"));
@@ -110,8 +145,11 @@ void Game::Update(float dt)
     Ball->Move(dt, this->Width);
     // check for collisions
     this->DoCollisions();
-    // update particles
-    Particles->Update(dt, *Ball, 2, glm::vec2(Ball->Radius / 2.0f));
+    // update particles (they live for a second, so spawning amount * dt of them keeps the stress test's pool full)
+    auto particleStart = std::chrono::steady_clock::now();
+    unsigned int newParticles = StressParticles > 0 ? std::max(static_cast<unsigned int>(StressParticles * dt), 2u) : 2;
+    Particles->Update(dt, *Ball, newParticles, glm::vec2(Ball->Radius / 2.0f));
+    ParticleUpdateTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - particleStart).count();
     // update PowerUps
     this->UpdatePowerUps(dt);
     // reduce shake time
@@ -213,24 +251,40 @@ void Game::Render()
             // draw background
             Renderer->DrawSprite(ResourceManager::GetTexture("background"), glm::vec2(0.0f, 0.0f), glm::vec2(this->Width, this->Height), 0.0f);
             // draw level
+            auto levelStart = std::chrono::steady_clock::now();
+            unsigned int levelDrawCalls = Renderer->DrawCalls;
             this->Levels[this->Level].Draw(*Renderer);
+            double average;
+            if (StressBricks > 0 && LevelTimer.Add(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - levelStart).count(), average))
+                std::cout << "level: " << this->Levels[this->Level].Bricks.size() << " bricks, " << average << " ms CPU and " << Renderer->DrawCalls - levelDrawCalls << " draw calls per frame" << std::endl;
             // draw player
             Player->Draw(*Renderer);
             // draw PowerUps
             for (PowerUp &powerUp : this->PowerUps)
                 if (!powerUp.Destroyed)
                     powerUp.Draw(*Renderer);
+            Renderer->Flush();
             // draw particles	
+            auto particleStart = std::chrono::steady_clock::now();
             Particles->Draw();
+            double particleTime = ParticleUpdateTime + std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - particleStart).count();
+            if (StressParticles > 0 && ParticleTimer.Add(particleTime, average))
+                std::cout << "particles: " << Particles->Count() << " alive, " << average << " ms CPU per frame to update and draw" << std::endl;
             // draw ball
             Ball->Draw(*Renderer);            
+            Renderer->Flush();
         // end rendering to postprocessing framebuffer
         Effects->EndRender();
         // render postprocessing quad
         Effects->Render(glfwGetTime());
-        // render text (don't include in postprocessing)
-        std::stringstream ss; ss << this->Lives;
-        Text->RenderText("Lives:" + ss.str(), 5.0f, 5.0f, 1.0f);
+        // render text (don't include in postprocessing); the string only changes with the number of lives
+        if (this->Lives != ShownLives)
+        {
+            std::stringstream ss; ss << this->Lives;
+            LivesText = "Lives:" + ss.str();
+            ShownLives = this->Lives;
+        }
+        Text->RenderText(LivesText, 5.0f, 5.0f, 1.0f);
     }
     if (this->State == GAME_MENU)
     {
@@ -242,12 +296,16 @@ void Game::Render()
         Text->RenderText("You WON!!!", 320.0f, this->Height / 2.0f - 20.0f, 1.0f, glm::vec3(0.0f, 1.0f, 0.0f));
         Text->RenderText("Press ENTER to retry or ESC to quit", 130.0f, this->Height / 2.0f, 1.0f, glm::vec3(1.0f, 1.0f, 0.0f));
     }
+    // all text of the frame in one draw call
+    Text->Flush();
 }
 
 
 void Game::ResetLevel()
 {
-    if (this->Level == 0)
+    if (this->Level == 0 && StressBricks > 0)
+        this->Levels[0].Generate(StressBricks, this->Width, this->Height / 2);
+    else if (this->Level == 0)
         this->Levels[0].Load("levels/one.lvl", this->Width, this->Height / 2);
     else if (this->Level == 1)
         this->Levels[1].Load("levels/two.lvl", this->Width, this->Height / 2);
@@ -404,55 +462,7 @@ Direction VectorDirection(glm::vec2 closest);
 
 void Game::DoCollisions()
 {
-    for (GameObject &box : this->Levels[this->Level].Bricks)
-    {
-        if (!box.Destroyed)
-        {
-            Collision collision = CheckCollision(*Ball, box);
-            if (std::get<0>(collision)) // if collision is true
-            {
-                // destroy block if not solid
-                if (!box.IsSolid)
-                {
-                    box.Destroyed = true;
-                    this->SpawnPowerUps(box);
-                    SoundEngine->play2D(FileSystem::getPath("resources/audio/bleep.mp3").c_str(), false);
-                }
-                else
-                {   // if block is solid, enable shake effect
-                    ShakeTime = 0.05f;
-                    Effects->Shake = true;
-                    SoundEngine->play2D(FileSystem::getPath("resources/audio/bleep.mp3").c_str(), false);
-                }
-                // collision resolution
-                Direction dir = std::get<1>(collision);
-                glm::vec2 diff_vector = std::get<2>(collision);
-                if (!(Ball->PassThrough && !box.IsSolid)) // don't do collision resolution on non-solid bricks if pass-through is activated
-                {
-                    if (dir == LEFT || dir == RIGHT) // horizontal collision
-                    {
-                        Ball->Velocity.x = -Ball->Velocity.x; // reverse horizontal velocity
-                        // relocate
-                        float penetration = Ball->Radius - std::abs(diff_vector.x);
-                        if (dir == LEFT)
-                            Ball->Position.x += penetration; // move ball to right
-                        else
-                            Ball->Position.x -= penetration; // move ball to left;
-                    }
-                    else // vertical collision
-                    {
-                        Ball->Velocity.y = -Ball->Velocity.y; // reverse vertical velocity
-                        // relocate
-                        float penetration = Ball->Radius - std::abs(diff_vector.y);
-                        if (dir == UP)
-                            Ball->Position.y -= penetration; // move ball bback up
-                        else
-                            Ball->Position.y += penetration; // move ball back down
-                    }
-                }
-            }
-        }    
-    }
+    this->DoCollisions(*Ball);
 
     // also check collisions on PowerUps and if so, activate them
     for (PowerUp &powerUp : this->PowerUps)
@@ -497,6 +507,64 @@ void Game::DoCollisions()
     }
 }
 
+void Game::DoCollisions(BallObject &ball)
+{
+    // only the bricks in the cells around the ball can collide with it; the margin of a radius covers where the
+    // collision resolution below may move the ball to
+    GameLevel &level = this->Levels[this->Level];
+    level.Query(ball.Position - ball.Radius, ball.Position + 3.0f * ball.Radius, this->candidates);
+    for (unsigned int brick : this->candidates)
+    {
+        GameObject &box = level.Bricks[brick];
+        if (!box.Destroyed)
+        {
+            Collision collision = CheckCollision(ball, box);
+            if (std::get<0>(collision)) // if collision is true
+            {
+                // destroy block if not solid
+                if (!box.IsSolid)
+                {
+                    level.Destroy(brick);
+                    this->SpawnPowerUps(box);
+                    SoundEngine->play2D(FileSystem::getPath("resources/audio/bleep.mp3").c_str(), false);
+                }
+                else
+                {   // if block is solid, enable shake effect
+                    ShakeTime = 0.05f;
+                    Effects->Shake = true;
+                    SoundEngine->play2D(FileSystem::getPath("resources/audio/bleep.mp3").c_str(), false);
+                }
+                // collision resolution
+                Direction dir = std::get<1>(collision);
+                glm::vec2 diff_vector = std::get<2>(collision);
+                if (!(ball.PassThrough && !box.IsSolid)) // don't do collision resolution on non-solid bricks if pass-through is activated
+                {
+                    if (dir == LEFT || dir == RIGHT) // horizontal collision
+                    {
+                        ball.Velocity.x = -ball.Velocity.x; // reverse horizontal velocity
+                        // relocate
+                        float penetration = ball.Radius - std::abs(diff_vector.x);
+                        if (dir == LEFT)
+                            ball.Position.x += penetration; // move ball to right
+                        else
+                            ball.Position.x -= penetration; // move ball to left;
+                    }
+                    else // vertical collision
+                    {
+                        ball.Velocity.y = -ball.Velocity.y; // reverse vertical velocity
+                        // relocate
+                        float penetration = ball.Radius - std::abs(diff_vector.y);
+                        if (dir == UP)
+                            ball.Position.y -= penetration; // move ball bback up
+                        else
+                            ball.Position.y += penetration; // move ball back down
+                    }
+                }
+            }
+        }    
+    }
+}
+
 bool CheckCollision(GameObject &one, GameObject &two) // AABB - AABB collision
 {
     // collision x-axis?
@@ -552,3 +620,16 @@ Direction VectorDirection(glm::vec2 target)
     }
     return (Direction)best_match;
 }
+
+bool StressTimer::Add(double milliseconds, double &average)
+{
+    this->Total += milliseconds;
+    ++this->Frames;
+    if (std::chrono::steady_clock::now() - this->LastPrint < std::chrono::seconds(5))
+        return false;
+    average = this->Total / this->Frames;
+    this->Total = 0.0;
+    this->Frames = 0;
+    this->LastPrint = std::chrono::steady_clock::now();
+    return true;
+}
\ No newline at end of file
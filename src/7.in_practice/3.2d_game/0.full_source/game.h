@@ -17,6 +17,8 @@
 #include "game_level.h"
 #include "power_up.h"
 
+class BallObject;
+
 // Represents the current state of the game
 enum GameState {
     GAME_ACTIVE,
@@ -63,17 +65,24 @@ public:
     ~Game();
     // initialize game state (load all shaders/textures/levels)
     void Init();
+    // delete the renderers and their buffers; call while the OpenGL context is still alive
+    void Clear();
     // game loop
     void ProcessInput(float dt);
     void Update(float dt);
     void Render();
     void DoCollisions();
+    // collides one ball with the bricks of the current level
+    void DoCollisions(BallObject &ball);
     // reset
     void ResetLevel();
     void ResetPlayer();
     // powerups
     void SpawnPowerUps(GameObject &block);
     void UpdatePowerUps(float dt);
+private:
+    // bricks near a ball, filled by DoCollisions(BallObject&); kept to reuse its storage
+    std::vector<unsigned int> candidates;
 };
 
 #endif
\ No newline at end of file
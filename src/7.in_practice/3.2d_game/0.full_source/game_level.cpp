@@ -8,6 +8,9 @@
 ******************************************************************/
 #include "game_level.h"
 
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
 #include <fstream>
 #include <sstream>
 
@@ -15,7 +18,7 @@
 void GameLevel::Load(const char *file, unsigned int levelWidth, unsigned int levelHeight)
 {
     // clear old data
-    this->Bricks.clear();
+    this->clear();
     // load from file
     unsigned int tileCode;
     GameLevel level;
@@ -37,19 +40,77 @@ void GameLevel::Load(const char *file, unsigned int levelWidth, unsigned int lev
     }
 }
 
+void GameLevel::Generate(unsigned int bricks, unsigned int levelWidth, unsigned int levelHeight)
+{
+    // clear old data
+    this->clear();
+    // a grid with about the aspect ratio of the default levels' bricks (4:1 wide), filled with random tiles
+    unsigned int rows = static_cast<unsigned int>(std::ceil(std::sqrt(bricks * levelHeight * 4.0f / levelWidth)));
+    unsigned int columns = (bricks + rows - 1) / rows;
+    std::vector<std::vector<unsigned int>> tileData(rows, std::vector<unsigned int>(columns));
+    for (std::vector<unsigned int> &row : tileData)
+        for (unsigned int &tile : row)
+            tile = 1 + rand() % 5;
+    this->init(tileData, levelWidth, levelHeight);
+}
+
 void GameLevel::Draw(SpriteRenderer &renderer)
 {
+    renderer.Flush();
     for (GameObject &tile : this->Bricks)
         if (!tile.Destroyed)
             tile.Draw(renderer);
+    renderer.Flush(true);
 }
 
 bool GameLevel::IsCompleted()
 {
-    for (GameObject &tile : this->Bricks)
-        if (!tile.IsSolid && !tile.Destroyed)
-            return false;
-    return true;
+    return this->remaining == 0;
+}
+
+void GameLevel::Query(glm::vec2 min, glm::vec2 max, std::vector<unsigned int> &bricks) const
+{
+    bricks.clear();
+    // no tiles (nothing loaded, or an empty file): no cells to look in, and unit sizes of 0
+    if (this->grid.empty())
+        return;
+    // the level starts at the origin, so cell (x, y) covers [x, x + 1] * unit size; a cell index is clamped to
+    // one past either side before it's converted, as a float outside the int range doesn't convert
+    auto cell = [](float position, float unit, unsigned int cells) {
+        return static_cast<int>(glm::clamp(std::floor(position / unit), -1.0f, static_cast<float>(cells)));
+    };
+    int firstColumn = std::max(cell(min.x, this->unitWidth, this->columns), 0);
+    int lastColumn = std::min(cell(max.x, this->unitWidth, this->columns), static_cast<int>(this->columns) - 1);
+    int firstRow = std::max(cell(min.y, this->unitHeight, this->rows), 0);
+    int lastRow = std::min(cell(max.y, this->unitHeight, this->rows), static_cast<int>(this->rows) - 1);
+    for (int y = firstRow; y <= lastRow; ++y)
+        for (int x = firstColumn; x <= lastColumn; ++x)
+        {
+            int brick = this->grid[y * this->columns + x];
+            if (brick >= 0)
+                bricks.push_back(brick);
+        }
+}
+
+void GameLevel::Destroy(unsigned int brick)
+{
+    GameObject &tile = this->Bricks[brick];
+    if (tile.Destroyed)
+        return;
+    tile.Destroyed = true;
+    this->grid[this->brickCells[brick]] = -1;
+    if (!tile.IsSolid)
+        --this->remaining;
+}
+
+void GameLevel::clear()
+{
+    this->Bricks.clear();
+    this->grid.clear();
+    this->brickCells.clear();
+    this->columns = this->rows = 0;
+    this->unitWidth = this->unitHeight = 0.0f;
+    this->remaining = 0;
 }
 
 void GameLevel::init(std::vector<std::vector<unsigned int>> tileData, unsigned int levelWidth, unsigned int levelHeight)
@@ -57,7 +118,12 @@ void GameLevel::init(std::vector<std::vector<unsigned int>> tileData, unsigned i
     // calculate dimensions
     unsigned int height = tileData.size();
     unsigned int width = tileData[0].size(); // note we can index vector at [0] since this function is only called if height > 0
-    float unit_width = levelWidth / static_cast<float>(width), unit_height = levelHeight / height; 
+    float unit_width = levelWidth / static_cast<float>(width), unit_height = levelHeight / static_cast<float>(height); 
+    this->columns = width;
+    this->rows = height;
+    this->unitWidth = unit_width;
+    this->unitHeight = unit_height;
+    this->grid.assign(width * height, -1);
     // initialize level tiles based on tileData		
     for (unsigned int y = 0; y < height; ++y)
     {
@@ -70,6 +136,8 @@ void GameLevel::init(std::vector<std::vector<unsigned int>> tileData, unsigned i
                 glm::vec2 size(unit_width, unit_height);
                 GameObject obj(pos, size, ResourceManager::GetTexture("block_solid"), glm::vec3(0.8f, 0.8f, 0.7f));
                 obj.IsSolid = true;
+                this->grid[y * width + x] = this->Bricks.size();
+                this->brickCells.push_back(y * width + x);
                 this->Bricks.push_back(obj);
             }
             else if (tileData[y][x] > 1)	// non-solid; now determine its color based on level data
@@ -86,7 +154,10 @@ void GameLevel::init(std::vector<std::vector<unsigned int>> tileData, unsigned i
 
                 glm::vec2 pos(unit_width * x, unit_height * y);
                 glm::vec2 size(unit_width, unit_height);
+                this->grid[y * width + x] = this->Bricks.size();
+                this->brickCells.push_back(y * width + x);
                 this->Bricks.push_back(GameObject(pos, size, ResourceManager::GetTexture("block"), color));
+                ++this->remaining;
             }
         }
     }
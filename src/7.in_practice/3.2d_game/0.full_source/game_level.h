@@ -20,20 +20,39 @@
 
 /// GameLevel holds all Tiles as part of a Breakout level and 
 /// hosts functionality to Load/render levels from the harddisk.
+/// The tiles of a level form a grid, which also serves as the
+/// broadphase for collisions: every cell holds the brick in it,
+/// so the bricks near an object are found by looking at the few
+/// cells it overlaps instead of testing every brick.
 class GameLevel
 {
 public:
-    // level state
+    // level state (destroy bricks through Destroy, so the grid stays up to date)
     std::vector<GameObject> Bricks;
     // constructor
-    GameLevel() { }
+    GameLevel() : columns(0), rows(0), unitWidth(0.0f), unitHeight(0.0f), remaining(0) { }
     // loads level from file
     void Load(const char *file, unsigned int levelWidth, unsigned int levelHeight);
-    // render level
+    // generates a random level of about the given number of bricks (for stress testing)
+    void Generate(unsigned int bricks, unsigned int levelWidth, unsigned int levelHeight);
+    // render level; draws what was queued before first, the bricks don't overlap so they are batched by texture
     void Draw(SpriteRenderer &renderer);
     // check if the level is completed (all non-solid tiles are destroyed)
     bool IsCompleted();
+    // collects the indices of the live bricks in the cells overlapping the box from min to max, in row order
+    void Query(glm::vec2 min, glm::vec2 max, std::vector<unsigned int> &bricks) const;
+    // destroys a brick and removes it from the grid
+    void Destroy(unsigned int brick);
 private:
+    // the grid: per cell the index of its brick or -1, and per brick its cell
+    std::vector<int>          grid;
+    std::vector<unsigned int> brickCells;
+    unsigned int              columns, rows;
+    float                     unitWidth, unitHeight;
+    // number of non-solid bricks left
+    unsigned int              remaining;
+    // removes all bricks
+    void clear();
     // initialize level from tile data
     void init(std::vector<std::vector<unsigned int>> tileData, unsigned int levelWidth, unsigned int levelHeight);
 };
@@ -0,0 +1,82 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#include "instance_stream.h"
+
+
+InstanceStream::InstanceStream(unsigned int instanceSize, unsigned int instanceCount, unsigned int segments)
+    : ID(0), instanceSize(instanceSize), segmentSize(0), segment(0), used(0), pending(0), fences(segments > 0 ? segments : 1, nullptr)
+{
+    this->allocate(instanceCount);
+}
+
+InstanceStream::~InstanceStream()
+{
+    for (unsigned int i = 0; i < this->fences.size(); ++i)
+        this->wait(i);
+    glDeleteBuffers(1, &this->ID);
+}
+
+void *InstanceStream::Begin(unsigned int count)
+{
+    unsigned int bytes = count * this->instanceSize;
+    if (bytes > this->segmentSize)
+    {
+        // doesn't fit in any segment: start over with a bigger buffer
+        this->allocate(count);
+    }
+    else if (this->used + bytes > this->segmentSize)
+    {
+        // the draws reading the current segment are all issued, so fence it and move on to the next
+        this->fences[this->segment] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        this->segment = (this->segment + 1) % this->fences.size();
+        this->used = 0;
+        this->wait(this->segment);
+    }
+    this->pending = bytes;
+    glBindBuffer(GL_ARRAY_BUFFER, this->ID);
+    // unsynchronized: the fences above already guarantee the GPU is not reading this range
+    return glMapBufferRange(GL_ARRAY_BUFFER, this->segment * this->segmentSize + this->used, bytes > 0 ? bytes : this->instanceSize,
+        GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+}
+
+GLintptr InstanceStream::End()
+{
+    glBindBuffer(GL_ARRAY_BUFFER, this->ID);
+    glUnmapBuffer(GL_ARRAY_BUFFER);
+    GLintptr offset = this->segment * this->segmentSize + this->used;
+    this->used += this->pending;
+    this->pending = 0;
+    return offset;
+}
+
+void InstanceStream::allocate(unsigned int count)
+{
+    // growing is rare, so simply wait for the GPU to finish with the old buffer
+    for (unsigned int i = 0; i < this->fences.size(); ++i)
+        this->wait(i);
+    this->segmentSize = count * this->instanceSize > this->segmentSize * 2 ? count * this->instanceSize : this->segmentSize * 2;
+    this->segment = 0;
+    this->used = 0;
+    if (this->ID == 0)
+        glGenBuffers(1, &this->ID);
+    glBindBuffer(GL_ARRAY_BUFFER, this->ID);
+    glBufferData(GL_ARRAY_BUFFER, this->segmentSize * this->fences.size(), nullptr, GL_STREAM_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void InstanceStream::wait(unsigned int segment)
+{
+    GLsync &fence = this->fences[segment];
+    if (!fence)
+        return;
+    while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000) == GL_TIMEOUT_EXPIRED)
+        ;
+    glDeleteSync(fence);
+    fence = nullptr;
+}
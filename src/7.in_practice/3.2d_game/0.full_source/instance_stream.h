@@ -0,0 +1,52 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#ifndef INSTANCE_STREAM_H
+#define INSTANCE_STREAM_H
+#include <vector>
+
+#include <glad/glad.h>
+
+
+// InstanceStream is a vertex buffer for per-instance data that is
+// rewritten every frame. It is a ring of segments: writes go to
+// the current segment until it is full, then the stream fences it
+// and moves on to the next one, waiting only if the GPU is still
+// reading that one. Writes map their range unsynchronized, so the
+// driver never stalls or copies the buffer behind the frame being
+// drawn.
+class InstanceStream
+{
+public:
+    // the vertex buffer, for glVertexAttribPointer; changes when the stream grows
+    unsigned int ID;
+    // constructor (instanceSize in bytes, room for instanceCount instances per segment)
+    InstanceStream(unsigned int instanceSize, unsigned int instanceCount = 1024, unsigned int segments = 3);
+    // destructor
+    ~InstanceStream();
+    // maps room for count instances and returns where to write them; every Begin needs an End before drawing
+    void *Begin(unsigned int count);
+    // unmaps what Begin mapped and returns its byte offset in the buffer, to point the instance attributes at
+    GLintptr End();
+private:
+    // state
+    unsigned int instanceSize;
+    unsigned int segmentSize;    // in bytes
+    unsigned int segment;        // the one being written
+    unsigned int used;           // bytes written to it so far
+    unsigned int pending;        // bytes mapped by Begin
+    std::vector<GLsync> fences;  // per segment, set when the stream moves past it
+    // (re)creates the buffer with room for at least count instances per segment
+    void allocate(unsigned int count);
+    // waits until the GPU is done with the given segment
+    void wait(unsigned int segment);
+    InstanceStream(const InstanceStream&) = delete;
+    InstanceStream& operator=(const InstanceStream&) = delete;
+};
+
+#endif
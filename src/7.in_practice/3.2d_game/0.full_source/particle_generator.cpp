@@ -6,53 +6,93 @@
 ** Creative Commons, either version 4 of the License, or (at your
 ** option) any later version.
 ******************************************************************/
+#include <cstdlib>
+#include <cstring>
+
 #include "particle_generator.h"
 
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define PARTICLES_SSE
+#endif
+
 ParticleGenerator::ParticleGenerator(Shader shader, Texture2D texture, unsigned int amount)
-    : shader(shader), texture(texture), amount(amount)
+    : amount(amount), count(0), shader(shader), texture(texture), stream(4 * sizeof(float), amount)
 {
     this->init();
 }
 
 void ParticleGenerator::Update(float dt, GameObject &object, unsigned int newParticles, glm::vec2 offset)
 {
-    // add new particles 
-    for (unsigned int i = 0; i < newParticles; ++i)
+    // add new particles after the live ones (none once all are taken; more particles should be reserved then)
+    for (unsigned int i = 0; i < newParticles && this->count < this->amount; ++i)
+        this->respawnParticle(this->count++, object, offset);
+    // update all particles
+    float *positionX = this->positionX.data(), *positionY = this->positionY.data();
+    const float *velocityX = this->velocityX.data(), *velocityY = this->velocityY.data();
+    float *alpha = this->alpha.data(), *life = this->life.data();
+    unsigned int i = 0;
+#ifdef PARTICLES_SSE
+    const __m128 step = _mm_set1_ps(dt), fade = _mm_set1_ps(dt * 2.5f);
+    for (; i + 4 <= this->count; i += 4)
     {
-        int unusedParticle = this->firstUnusedParticle();
-        this->respawnParticle(this->particles[unusedParticle], object, offset);
+        _mm_storeu_ps(life + i, _mm_sub_ps(_mm_loadu_ps(life + i), step));
+        _mm_storeu_ps(positionX + i, _mm_sub_ps(_mm_loadu_ps(positionX + i), _mm_mul_ps(_mm_loadu_ps(velocityX + i), step)));
+        _mm_storeu_ps(positionY + i, _mm_sub_ps(_mm_loadu_ps(positionY + i), _mm_mul_ps(_mm_loadu_ps(velocityY + i), step)));
+        _mm_storeu_ps(alpha + i, _mm_sub_ps(_mm_loadu_ps(alpha + i), fade));
     }
-    // update all particles
-    for (unsigned int i = 0; i < this->amount; ++i)
+#endif
+    for (; i < this->count; ++i)
+    {
+        life[i] -= dt; // reduce life
+        positionX[i] -= velocityX[i] * dt;
+        positionY[i] -= velocityY[i] * dt;
+        alpha[i] -= dt * 2.5f;
+    }
+    // kill dead particles by moving the last live one into their place
+    for (i = 0; i < this->count; )
     {
-        Particle &p = this->particles[i];
-        p.Life -= dt; // reduce life
-        if (p.Life > 0.0f)
-        {	// particle is alive, thus update
-            p.Position -= p.Velocity * dt; 
-            p.Color.a -= dt * 2.5f;
+        if (life[i] > 0.0f)
+        {
+            ++i;
+            continue;
         }
+        unsigned int last = --this->count;
+        this->positionX[i] = this->positionX[last];
+        this->positionY[i] = this->positionY[last];
+        this->velocityX[i] = this->velocityX[last];
+        this->velocityY[i] = this->velocityY[last];
+        this->brightness[i] = this->brightness[last];
+        this->alpha[i] = this->alpha[last];
+        this->life[i] = this->life[last];
     }
 }
 
 // render all particles
 void ParticleGenerator::Draw()
 {
+    if (this->count == 0)
+        return;
+    // the instance data is the arrays one after the other: x, y, brightness and alpha of every particle
+    size_t bytes = this->count * sizeof(float);
+    char *out = static_cast<char*>(this->stream.Begin(this->count));
+    memcpy(out, this->positionX.data(), bytes);
+    memcpy(out + bytes, this->positionY.data(), bytes);
+    memcpy(out + 2 * bytes, this->brightness.data(), bytes);
+    memcpy(out + 3 * bytes, this->alpha.data(), bytes);
+    GLintptr offset = this->stream.End();
+
     // use additive blending to give it a 'glow' effect
     glBlendFunc(GL_SRC_ALPHA, GL_ONE);
     this->shader.Use();
-    for (Particle particle : this->particles)
-    {
-        if (particle.Life > 0.0f)
-        {
-            this->shader.SetVector2f("offset", particle.Position);
-            this->shader.SetVector4f("color", particle.Color);
-            this->texture.Bind();
-            glBindVertexArray(this->VAO);
-            glDrawArrays(GL_TRIANGLES, 0, 6);
-            glBindVertexArray(0);
-        }
-    }
+    this->texture.Bind();
+    glBindVertexArray(this->VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, this->stream.ID);
+    for (unsigned int attribute = 0; attribute < 4; ++attribute)
+        glVertexAttribPointer(1 + attribute, 1, GL_FLOAT, GL_FALSE, sizeof(float), (void*)(offset + attribute * bytes));
+    glDrawArraysInstanced(GL_TRIANGLES, 0, 6, this->count);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
     // don't forget to reset to default blending mode
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 }
@@ -79,42 +119,28 @@ void ParticleGenerator::init()
     // set mesh attributes
     glEnableVertexAttribArray(0);
     glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
+    // per-particle attributes (x, y, brightness, alpha), pointed at the stream by Draw
+    for (unsigned int attribute = 1; attribute <= 4; ++attribute)
+    {
+        glEnableVertexAttribArray(attribute);
+        glVertexAttribDivisor(attribute, 1);
+    }
     glBindVertexArray(0);
 
-    // create this->amount default particle instances
-    for (unsigned int i = 0; i < this->amount; ++i)
-        this->particles.push_back(Particle());
-}
-
-// stores the index of the last particle used (for quick access to next dead particle)
-unsigned int lastUsedParticle = 0;
-unsigned int ParticleGenerator::firstUnusedParticle()
-{
-    // first search from last used particle, this will usually return almost instantly
-    for (unsigned int i = lastUsedParticle; i < this->amount; ++i){
-        if (this->particles[i].Life <= 0.0f){
-            lastUsedParticle = i;
-            return i;
-        }
-    }
-    // otherwise, do a linear search
-    for (unsigned int i = 0; i < lastUsedParticle; ++i){
-        if (this->particles[i].Life <= 0.0f){
-            lastUsedParticle = i;
-            return i;
-        }
-    }
-    // all particles are taken, override the first one (note that if it repeatedly hits this case, more particles should be reserved)
-    lastUsedParticle = 0;
-    return 0;
+    // room for this->amount particles, none of them alive yet
+    for (std::vector<float> *property : { &this->positionX, &this->positionY, &this->velocityX, &this->velocityY, &this->brightness, &this->alpha, &this->life })
+        property->resize(this->amount, 0.0f);
 }
 
-void ParticleGenerator::respawnParticle(Particle &particle, GameObject &object, glm::vec2 offset)
+void ParticleGenerator::respawnParticle(unsigned int index, GameObject &object, glm::vec2 offset)
 {
     float random = ((rand() % 100) - 50) / 10.0f;
     float rColor = 0.5f + ((rand() % 100) / 100.0f);
-    particle.Position = object.Position + random + offset;
-    particle.Color = glm::vec4(rColor, rColor, rColor, 1.0f);
-    particle.Life = 1.0f;
-    particle.Velocity = object.Velocity * 0.1f;
+    this->positionX[index] = object.Position.x + random + offset.x;
+    this->positionY[index] = object.Position.y + random + offset.y;
+    this->brightness[index] = rColor;
+    this->alpha[index] = 1.0f;
+    this->life[index] = 1.0f;
+    this->velocityX[index] = object.Velocity.x * 0.1f;
+    this->velocityY[index] = object.Velocity.y * 0.1f;
 }
\ No newline at end of file
@@ -16,21 +16,16 @@
 #include "shader.h"
 #include "texture.h"
 #include "game_object.h"
-
-
-// Represents a single particle and its state
-struct Particle {
-    glm::vec2 Position, Velocity;
-    glm::vec4 Color;
-    float     Life;
-
-    Particle() : Position(0.0f), Velocity(0.0f), Color(1.0f), Life(0.0f) { }
-};
+#include "instance_stream.h"
 
 
 // ParticleGenerator acts as a container for rendering a large number of 
 // particles by repeatedly spawning and updating particles and killing 
-// them after a given amount of time.
+// them after a given amount of time. The particles are stored as one
+// array per property (structure of arrays) with the live ones first:
+// new particles go at the end and a dead particle is replaced by the
+// last live one. Updates run over the arrays 4 particles at a time and
+// the arrays are uploaded as they are for one instanced draw call.
 class ParticleGenerator
 {
 public:
@@ -40,20 +35,23 @@ public:
     void Update(float dt, GameObject &object, unsigned int newParticles, glm::vec2 offset = glm::vec2(0.0f, 0.0f));
     // render all particles
     void Draw();
+    // number of live particles
+    unsigned int Count() const { return this->count; }
 private:
-    // state
-    std::vector<Particle> particles;
+    // state, one entry per particle of which the first count are alive
+    std::vector<float> positionX, positionY, velocityX, velocityY;
+    std::vector<float> brightness, alpha, life;
     unsigned int amount;
+    unsigned int count;
     // render state
     Shader shader;
     Texture2D texture;
     unsigned int VAO;
+    InstanceStream stream;
     // initializes buffer and vertex attributes
     void init();
-    // returns the first Particle index that's currently unused e.g. Life <= 0.0f or 0 if no particle is currently inactive
-    unsigned int firstUnusedParticle();
-    // respawns particle
-    void respawnParticle(Particle &particle, GameObject &object, glm::vec2 offset = glm::vec2(0.0f, 0.0f));
+    // respawns the particle at the given index
+    void respawnParticle(unsigned int index, GameObject &object, glm::vec2 offset = glm::vec2(0.0f, 0.0f));
 };
 
 #endif
\ No newline at end of file
@@ -91,8 +91,9 @@ int main(int argc, char *argv[])
         glfwSwapBuffers(window);
     }
 
-    // delete all resources as loaded using the resource manager
-    // ---------------------------------------------------------
+    // delete the game's renderers and all resources as loaded using the resource manager
+    // -----------------------------------------------------------------------------------
+    Breakout.Clear();
     ResourceManager::Clear();
 
     glfwTerminate();
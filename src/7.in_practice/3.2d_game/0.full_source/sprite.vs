@@ -1,14 +1,21 @@
 #version 330 core
 layout (location = 0) in vec4 vertex; // <vec2 position, vec2 texCoords>
+layout (location = 1) in vec4 rect; // per sprite: <vec2 position, vec2 size>
+layout (location = 2) in vec4 colorRotation; // per sprite: <vec3 color, float rotation in radians>
 
 out vec2 TexCoords;
+out vec3 SpriteColor;
 
-uniform mat4 model;
 // note that we're omitting the view matrix; the view never changes so we basically have an identity view matrix and can therefore omit it.
 uniform mat4 projection;
 
 void main()
 {
     TexCoords = vertex.zw;
-    gl_Position = projection * model * vec4(vertex.xy, 0.0, 1.0);
+    SpriteColor = colorRotation.rgb;
+    // scale, rotate around the center of the quad, then translate: the model matrix of a single sprite, without building it
+    vec2 local = (vertex.xy - 0.5) * rect.zw;
+    float s = sin(colorRotation.w), c = cos(colorRotation.w);
+    vec2 world = vec2(c * local.x - s * local.y, s * local.x + c * local.y) + rect.xy + 0.5 * rect.zw;
+    gl_Position = projection * vec4(world, 0.0, 1.0);
 }
\ No newline at end of file
@@ -6,10 +6,14 @@
 ** Creative Commons, either version 4 of the License, or (at your
 ** option) any later version.
 ******************************************************************/
+#include <algorithm>
+#include <cstddef>
+
 #include "sprite_renderer.h"
 
 
-SpriteRenderer::SpriteRenderer(Shader &shader)
+SpriteRenderer::SpriteRenderer(const Shader &shader)
+    : DrawCalls(0), stream(sizeof(SpriteInstance), 4096)
 {
     this->shader = shader;
     this->initRenderData();
@@ -20,30 +24,79 @@ SpriteRenderer::~SpriteRenderer()
     glDeleteVertexArrays(1, &this->quadVAO);
 }
 
-void SpriteRenderer::DrawSprite(Texture2D &texture, glm::vec2 position, glm::vec2 size, float rotate, glm::vec3 color)
+void SpriteRenderer::DrawSprite(const Texture2D &texture, glm::vec2 position, glm::vec2 size, float rotate, glm::vec3 color)
 {
-    // prepare transformations
-    this->shader.Use();
-    glm::mat4 model = glm::mat4(1.0f);
-    model = glm::translate(model, glm::vec3(position, 0.0f));  // first translate (transformations are: scale happens first, then rotation, and then final translation happens; reversed order)
-
-    model = glm::translate(model, glm::vec3(0.5f * size.x, 0.5f * size.y, 0.0f)); // move origin of rotation to center of quad
-    model = glm::rotate(model, glm::radians(rotate), glm::vec3(0.0f, 0.0f, 1.0f)); // then rotate
-    model = glm::translate(model, glm::vec3(-0.5f * size.x, -0.5f * size.y, 0.0f)); // move origin back
-
-    model = glm::scale(model, glm::vec3(size, 1.0f)); // last scale
-
-    this->shader.SetMatrix4("model", model);
+    // the shader scales, rotates around the center of the quad and translates, as model = T(position) * T(size / 2) * R(rotate) * T(-size / 2) * S(size) would
+    SpriteInstance sprite;
+    sprite.Rect = glm::vec4(position, size);
+    sprite.ColorRotation = glm::vec4(color, glm::radians(rotate));
+    this->sprites.push_back(sprite);
+    this->textures.push_back(texture.ID);
+}
 
-    // render textured quad
-    this->shader.SetVector3f("spriteColor", color);
+void SpriteRenderer::Flush(bool sortByTexture)
+{
+    unsigned int count = this->sprites.size();
+    if (count == 0)
+        return;
+    // runs of sprites sharing a texture, in the order they are drawn
+    struct Run { unsigned int texture, first, count; };
+    std::vector<Run> runs;
+    SpriteInstance *out = static_cast<SpriteInstance*>(this->stream.Begin(count));
+    if (sortByTexture)
+    {
+        // a counting sort: one run per texture, in the order the textures were first queued (there are only a few)
+        for (unsigned int i = 0; i < count; ++i)
+        {
+            unsigned int r = 0;
+            while (r < runs.size() && runs[r].texture != this->textures[i])
+                ++r;
+            if (r == runs.size())
+                runs.push_back({ this->textures[i], 0, 0 });
+            ++runs[r].count;
+        }
+        std::vector<unsigned int> next(runs.size());
+        for (unsigned int r = 1; r < runs.size(); ++r)
+            runs[r].first = next[r] = runs[r - 1].first + runs[r - 1].count;
+        unsigned int last = 0; // run of the previous sprite, usually the same one
+        for (unsigned int i = 0; i < count; ++i)
+        {
+            if (runs[last].texture != this->textures[i])
+                for (last = 0; runs[last].texture != this->textures[i]; ++last)
+                    ;
+            out[next[last]++] = this->sprites[i];
+        }
+    }
+    else
+    {
+        for (unsigned int i = 0; i < count; ++i)
+        {
+            if (runs.empty() || runs.back().texture != this->textures[i])
+                runs.push_back({ this->textures[i], i, 0 });
+            ++runs.back().count;
+        }
+        std::copy(this->sprites.begin(), this->sprites.end(), out);
+    }
+    GLintptr offset = this->stream.End();
 
+    // render the textured quads, re-pointing the per-sprite attributes at each run (there is no base instance in OpenGL 3.3)
+    this->shader.Use();
     glActiveTexture(GL_TEXTURE0);
-    texture.Bind();
-
     glBindVertexArray(this->quadVAO);
-    glDrawArrays(GL_TRIANGLES, 0, 6);
+    glBindBuffer(GL_ARRAY_BUFFER, this->stream.ID);
+    for (const Run &run : runs)
+    {
+        GLintptr first = offset + run.first * sizeof(SpriteInstance);
+        glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(SpriteInstance), (void*)(first + offsetof(SpriteInstance, Rect)));
+        glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(SpriteInstance), (void*)(first + offsetof(SpriteInstance, ColorRotation)));
+        glBindTexture(GL_TEXTURE_2D, run.texture);
+        glDrawArraysInstanced(GL_TRIANGLES, 0, 6, run.count);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
     glBindVertexArray(0);
+    this->DrawCalls += runs.size();
+    this->sprites.clear();
+    this->textures.clear();
 }
 
 void SpriteRenderer::initRenderData()
@@ -70,6 +123,11 @@ void SpriteRenderer::initRenderData()
     glBindVertexArray(this->quadVAO);
     glEnableVertexAttribArray(0);
     glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
+    // per-sprite attributes, pointed at the stream by Flush
+    glEnableVertexAttribArray(1);
+    glVertexAttribDivisor(1, 1);
+    glEnableVertexAttribArray(2);
+    glVertexAttribDivisor(2, 1);
     glBindBuffer(GL_ARRAY_BUFFER, 0);
     glBindVertexArray(0);
 }
\ No newline at end of file
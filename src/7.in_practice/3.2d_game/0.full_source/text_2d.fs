@@ -1,12 +1,20 @@
 #version 330 core
 in vec2 TexCoords;
+in vec3 TextColor;
 out vec4 color;
 
 uniform sampler2D text;
-uniform vec3 textColor;
+uniform bool distanceField;
 
 void main()
 {    
-    vec4 sampled = vec4(1.0, 1.0, 1.0, texture(text, TexCoords).r);
-    color = vec4(textColor, 1.0) * sampled;
+    float alpha = texture(text, TexCoords).r;
+    if (distanceField)
+    {
+        // the outline is at 0.5; smooth it over about a pixel on the screen, whatever the text's scale
+        float smoothing = 0.7 * fwidth(alpha);
+        alpha = smoothstep(0.5 - smoothing, 0.5 + smoothing, alpha);
+    }
+    vec4 sampled = vec4(1.0, 1.0, 1.0, alpha);
+    color = vec4(TextColor, 1.0) * sampled;
 }  
\ No newline at end of file
@@ -9,43 +9,41 @@
 #ifndef TEXT_RENDERER_H
 #define TEXT_RENDERER_H
 
-#include <map>
+#include <string>
 
 #include <glad/glad.h>
 #include <glm/glm.hpp>
+#include <learnopengl/glyph_atlas.h>
+#include <learnopengl/text_batch.h>
 
 #include "texture.h"
 #include "shader.h"
 
 
-/// Holds all state information relevant to a character as loaded using FreeType
-struct Character {
-    unsigned int TextureID; // ID handle of the glyph texture
-    glm::ivec2   Size;      // size of glyph
-    glm::ivec2   Bearing;   // offset from baseline to left/top of glyph
-    unsigned int Advance;   // horizontal offset to advance to next glyph
-};
-
-
 // A renderer class for rendering text displayed by a font loaded using the 
-// FreeType library. A single font is loaded, processed into a list of Character
-// items for later rendering.
+// FreeType library. A single font is loaded into one glyph atlas; the text
+// of a frame is collected and drawn with a single draw call by Flush.
+// By default the atlas holds distance fields, generated once at a fixed
+// size and cached on disk, so text stays sharp at any scale.
 class TextRenderer
 {
 public:
-    // holds a list of pre-compiled Characters
-    std::map<char, Character> Characters; 
+    // all characters of the font packed into a single texture
+    GlyphAtlas Atlas;
     // shader used for text rendering
     Shader TextShader;
     // constructor
     TextRenderer(unsigned int width, unsigned int height);
-    // pre-compiles a list of characters from the given font
-    void Load(std::string font, unsigned int fontSize);
-    // renders a string of text using the precompiled list of characters
-    void RenderText(std::string text, float x, float y, float scale, glm::vec3 color = glm::vec3(1.0f));
+    // pre-compiles a list of characters from the given font; text at scale 1 is fontSize pixels high
+    void Load(std::string font, unsigned int fontSize, bool distanceField = true);
+    // queues a string of text using the precompiled list of characters, drawn by the next Flush
+    void RenderText(const std::string &text, float x, float y, float scale, glm::vec3 color = glm::vec3(1.0f));
+    // renders all queued text
+    void Flush();
 private:
     // render state
-    unsigned int VAO, VBO;
+    TextBatch batch;
+    float     fontScale; // fontSize relative to the size the atlas was rasterized at
 };
 
-#endif 
\ No newline at end of file
+#endif
\ No newline at end of file
@@ -1,10 +1,9 @@
 #version 330 core
 
+// the compact SkinnedVertex layout (see vertex_format.h)
 layout(location = 0) in vec3 pos;
-layout(location = 1) in vec3 norm;
+layout(location = 1) in vec4 frame; // octahedral normal in xy, tangent in zw; unused, the sample is unlit
 layout(location = 2) in vec2 tex;
-layout(location = 3) in vec3 tangent;
-layout(location = 4) in vec3 bitangent;
 layout(location = 5) in ivec4 boneIds; 
 layout(location = 6) in vec4 weights;
 
@@ -12,9 +11,18 @@ uniform mat4 projection;
 uniform mat4 view;
 uniform mat4 model;
 
-const int MAX_BONES = 100;
 const int MAX_BONE_INFLUENCE = 4;
-uniform mat4 finalBonesMatrices[MAX_BONES];
+// the final bone matrices of all characters, four texels per matrix (see BonePaletteBuffer)
+uniform samplerBuffer bonePalette;
+uniform int paletteOffset; // first matrix of this character
+uniform int boneCount;
+
+mat4 boneMatrix(int id)
+{
+    int texel = (paletteOffset + id) * 4;
+    return mat4(texelFetch(bonePalette, texel), texelFetch(bonePalette, texel + 1),
+        texelFetch(bonePalette, texel + 2), texelFetch(bonePalette, texel + 3));
+}
 
 out vec2 TexCoords;
 
@@ -23,16 +31,16 @@ void main()
     vec4 totalPosition = vec4(0.0f);
     for(int i = 0 ; i < MAX_BONE_INFLUENCE ; i++)
     {
-        if(boneIds[i] == -1) 
+        if(weights[i] == 0.0) // unused influence
             continue;
-        if(boneIds[i] >=MAX_BONES) 
+        if(boneIds[i] >=boneCount) 
         {
             totalPosition = vec4(pos,1.0f);
             break;
         }
-        vec4 localPosition = finalBonesMatrices[boneIds[i]] * vec4(pos,1.0f);
+        mat4 bone = boneMatrix(boneIds[i]);
+        vec4 localPosition = bone * vec4(pos,1.0f);
         totalPosition += localPosition * weights[i];
-        vec3 localNormal = mat3(finalBonesMatrices[boneIds[i]]) * norm;
    }
 	
     mat4 viewModel = view * model;
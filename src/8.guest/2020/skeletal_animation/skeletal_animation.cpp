@@ -9,13 +9,18 @@
 #include <learnopengl/shader_m.h>
 #include <learnopengl/camera.h>
 #include <learnopengl/animator.h>
+#include <learnopengl/animation_system.h>
+#include <learnopengl/bone_palette_buffer.h>
 #include <learnopengl/model_animation.h>
 
 
 
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
 #include <iostream>
 
-
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
@@ -37,6 +42,10 @@ float lastFrame = 0.0f;
 
 int main()
 {
+	// number of dancers, e.g. characters=100
+	const char* charactersEnv = getenv("characters");
+	const int characterCount = charactersEnv ? std::max(atoi(charactersEnv), 1) : 1;
+
 	// glfw: initialize and configure
 	// ------------------------------
 	glfwInit();
@@ -80,67 +89,111 @@ int main()
 	// -----------------------------
 	glEnable(GL_DEPTH_TEST);
 
-	// build and compile shaders
-	// -------------------------
-	Shader ourShader("anim_model.vs", "anim_model.fs");
-
-	
-	// load models
-	// -----------
-	Model ourModel(FileSystem::getPath("resources/objects/vampire/dancing_vampire.dae"));
-	Animation danceAnimation(FileSystem::getPath("resources/objects/vampire/dancing_vampire.dae"),&ourModel);
-	Animator animator(&danceAnimation);
-
-
-	// draw in wireframe
-	//glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-
-	// render loop
-	// -----------
-	while (!glfwWindowShouldClose(window))
+	// the model, shader and palette buffer own GL objects, so they go before the context does
 	{
-		// per-frame time logic
-		// --------------------
-		float currentFrame = glfwGetTime();
-		deltaTime = currentFrame - lastFrame;
-		lastFrame = currentFrame;
-
-		// input
-		// -----
-		processInput(window);
-		animator.UpdateAnimation(deltaTime);
-		
-		// render
-		// ------
-		glClearColor(0.05f, 0.05f, 0.05f, 1.0f);
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		// build and compile shaders
+		// -------------------------
+		Shader ourShader("anim_model.vs", "anim_model.fs");
 
-		// don't forget to enable shader before setting uniforms
+	
+		// load models
+		// -----------
+		Model ourModel(FileSystem::getPath("resources/objects/vampire/dancing_vampire.dae"), false, true); // compact vertices
+		size_t fullSize = 0;
+		for (const Mesh& mesh : ourModel.meshes)
+			fullSize += mesh.vertices.size() * sizeof(Vertex);
+		printf("vertex buffers: %zu bytes (%zu with the full layout)\n", ourModel.vertexBufferSize(), fullSize);
+		Animation danceAnimation(FileSystem::getPath("resources/objects/vampire/dancing_vampire.dae"),&ourModel);
+		// compress the clip after import, e.g. compress_clips=1 (compress_bench in skeletal_animation_bench measures the error)
+		if (getenv("compress_clips"))
+		{
+			const size_t keyMemory = danceAnimation.GetKeyMemory();
+			danceAnimation.Compress();
+			printf("clip keys: %zu -> %zu bytes\n", keyMemory, danceAnimation.GetKeyMemory());
+		}
+		// as many matrices per character as the rig has bones, however many that is
+		const int boneCount = std::max(danceAnimation.GetPaletteSize(), ourModel.GetBoneCount());
+		AnimationSystem animations(boneCount);
+		for (int i = 0; i < characterCount; i++)
+			animations.AddInstance(&danceAnimation, 0.37f * i); // out of step, so the crowd doesn't move as one
+		const int columns = (int)std::ceil(std::sqrt((float)characterCount));
+
+		// all palettes go up as one buffer per frame, a character only sets where its palette starts
+		const int paletteUnit = 8; // clear of the model's material textures
+		BonePaletteBuffer palettes;
 		ourShader.use();
-
-		// view/projection transformations
-		glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
-		glm::mat4 view = camera.GetViewMatrix();
-		ourShader.setMat4("projection", projection);
-		ourShader.setMat4("view", view);
-
-        auto transforms = animator.GetFinalBoneMatrices();
-		for (int i = 0; i < transforms.size(); ++i)
-			ourShader.setMat4("finalBonesMatrices[" + std::to_string(i) + "]", transforms[i]);
-
-
-		// render the loaded model
-		glm::mat4 model = glm::mat4(1.0f);
-		model = glm::translate(model, glm::vec3(0.0f, -0.4f, 0.0f)); // translate it down so it's at the center of the scene
-		model = glm::scale(model, glm::vec3(.5f, .5f, .5f));	// it's a bit too big for our scene, so scale it down
-		ourShader.setMat4("model", model);
-		ourModel.Draw(ourShader);
-
-
-		// glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
-		// -------------------------------------------------------------------------------
-		glfwSwapBuffers(window);
-		glfwPollEvents();
+		ourShader.setInt("bonePalette", paletteUnit);
+		ourShader.setInt("boneCount", boneCount);
+		const GLint paletteOffsetLocation = glGetUniformLocation(ourShader.ID, "paletteOffset");
+		double uploadSeconds = 0.0, reportTime = glfwGetTime();
+		int uploadFrames = 0;
+
+
+		// draw in wireframe
+		//glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+
+		// render loop
+		// -----------
+		while (!glfwWindowShouldClose(window))
+		{
+			// per-frame time logic
+			// --------------------
+			float currentFrame = glfwGetTime();
+			deltaTime = currentFrame - lastFrame;
+			lastFrame = currentFrame;
+
+			// input
+			// -----
+			processInput(window);
+			animations.Update(deltaTime);
+		
+			// render
+			// ------
+			glClearColor(0.05f, 0.05f, 0.05f, 1.0f);
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+			// don't forget to enable shader before setting uniforms
+			ourShader.use();
+
+			// view/projection transformations
+			glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
+			glm::mat4 view = camera.GetViewMatrix();
+			ourShader.setMat4("projection", projection);
+			ourShader.setMat4("view", view);
+
+			// CPU cost of getting every palette to the GPU, reported every five seconds
+			const auto uploadStart = std::chrono::steady_clock::now();
+			const int paletteBase = palettes.Upload(animations.GetPalettes().data(), animations.GetPalettes().size());
+			palettes.Bind(paletteUnit);
+			uploadSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - uploadStart).count();
+			if (++uploadFrames, currentFrame - reportTime >= 5.0)
+			{
+				printf("bone palettes: %d characters, %d bones, %.1f us upload per frame, %.3f us per character (%s)\n",
+					characterCount, boneCount, uploadSeconds / uploadFrames * 1e6, uploadSeconds / uploadFrames / characterCount * 1e6,
+					palettes.IsPersistent() ? "persistent ring" : "mapped ring");
+				uploadSeconds = 0.0;
+				uploadFrames = 0;
+				reportTime = currentFrame;
+			}
+
+			for (int i = 0; i < characterCount; i++)
+			{
+				glUniform1i(paletteOffsetLocation, paletteBase + i * animations.GetBonesPerInstance());
+
+				// render the loaded model
+				glm::mat4 model = glm::mat4(1.0f);
+				model = glm::translate(model, glm::vec3(1.0f * (i % columns - (columns - 1) * 0.5f), -0.4f, -1.0f * (i / columns))); // a grid of dancers, moved down so it's at the center of the scene
+				model = glm::scale(model, glm::vec3(.5f, .5f, .5f));	// it's a bit too big for our scene, so scale it down
+				ourShader.setMat4("model", model);
+				ourModel.Draw(ourShader);
+			}
+
+
+			// glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
+			// -------------------------------------------------------------------------------
+			glfwSwapBuffers(window);
+			glfwPollEvents();
+		}
 	}
 
 	// glfw: terminate, clearing all previously allocated GLFW resources.
@@ -0,0 +1,507 @@
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <learnopengl/animator.h>
+#include <learnopengl/animation_system.h>
+#include <learnopengl/cpu_skinning.h>
+#include <learnopengl/model_animation.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <thread>
+
+// CPU only benchmarks of the skeletal animation code on synthetic clips and meshes; no window or GL context is
+// created. Pick one with an environment variable, e.g. anim_bench=36000 (see the *.bench tasks in the Runfile).
+
+void keyframeBenchmark(int keys, int bones);
+Animation makeSyntheticAnimation(int boneCount, int keys, float phase = 0.0f);
+void animatorBenchmark(int boneCount, int frames);
+void crowdBenchmark(int characters, int frames);
+void compressionReport(const char* name, const Animation& clip, const BoneCompression& settings);
+void blendBenchmark(int boneCount, int frames);
+void skinningBenchmark(int vertexCount, int frames);
+
+int main()
+{
+	// CPU only cost of a bone update on a long synthetic clip, e.g. anim_bench=36000 (10 minutes at 60 keys per second)
+	if (const char* bench = getenv("anim_bench"))
+	{
+		keyframeBenchmark(std::max(atoi(bench), 2), 64);
+		return 0;
+	}
+	// CPU only cost of one Animator update, recursive by name vs the compiled hierarchy, e.g. animator_bench=100
+	if (const char* bench = getenv("animator_bench"))
+	{
+		animatorBenchmark(std::min(std::max(atoi(bench), 1), 100), 2000);
+		return 0;
+	}
+	// CPU only throughput of AnimationSystem for a crowd, from one thread up to every core, e.g. crowd_bench=500
+	if (const char* bench = getenv("crowd_bench"))
+	{
+		crowdBenchmark(std::max(atoi(bench), 1), 200);
+		return 0;
+	}
+	// memory and error of clip compression on a 60 bone synthetic clip with this many keys per track, e.g. compress_bench=3600
+	if (const char* bench = getenv("compress_bench"))
+	{
+		compressionReport("synthetic", makeSyntheticAnimation(60, std::max(atoi(bench), 2)), BoneCompression());
+		return 0;
+	}
+	// CPU only cost of an Animator update playing one clip, crossfading two and with an additive layer on top, e.g. blend_bench=100
+	if (const char* bench = getenv("blend_bench"))
+	{
+		blendBenchmark(std::min(std::max(atoi(bench), 1), 100), 2000);
+		return 0;
+	}
+	// CPU skinning throughput, scalar reference vs the SIMD kernel on one and on all threads, e.g. skin_bench=1000000
+	if (const char* bench = getenv("skin_bench"))
+	{
+		skinningBenchmark(std::max(atoi(bench), 1), 20);
+		return 0;
+	}
+	printf("set one of anim_bench, animator_bench, crowd_bench, compress_bench, blend_bench or skin_bench\n");
+	return 1;
+}
+
+// per-bone update cost of a mocap-like clip: keys every tick (60 ticks per second) for position and rotation, one
+// scale key. Playback moves forward one tick per frame; seeks jump to random times.
+// ---------------------------------------------------------------------------------------------------------------
+void keyframeBenchmark(int keys, int bones)
+{
+	typedef std::chrono::steady_clock Clock;
+	auto elapsed = [](Clock::time_point start) { return std::chrono::duration<double, std::nano>(Clock::now() - start).count(); };
+
+	std::vector<Bone> clip;
+	for (int b = 0; b < bones; b++)
+	{
+		std::vector<KeyPosition> positions(keys);
+		std::vector<KeyRotation> rotations(keys);
+		for (int k = 0; k < keys; k++)
+		{
+			positions[k] = { glm::vec3(std::sin(k * 0.01f + b), std::cos(k * 0.013f), 0.1f * b), (float)k };
+			rotations[k] = { glm::angleAxis(std::sin(k * 0.02f + b), glm::normalize(glm::vec3(1.0f, b * 0.1f, 0.5f))), (float)k };
+		}
+		clip.emplace_back("bone" + std::to_string(b), b, positions, rotations, std::vector<KeyScale>{ { glm::vec3(1.0f), 0.0f } });
+	}
+	const float duration = float(keys - 1);
+	float checksum = 0.0f;
+
+	// the lookup before cursors: scan every track from key 0, then interpolate
+	const int stride = std::max(keys / 200, 1);
+	std::vector<BoneCursor> cursors(bones);
+	auto start = Clock::now();
+	size_t linearUpdates = 0;
+	for (int frame = 0; frame < keys; frame += stride)
+	{
+		const float time = frame + 0.5f;
+		for (int b = 0; b < bones; b++)
+		{
+			const auto& positions = clip[b].GetPositionKeys();
+			const auto& rotations = clip[b].GetRotationKeys();
+			int p = 0, r = 0;
+			while (p < keys - 2 && !(time < positions[p + 1].timeStamp))
+				p++;
+			while (r < keys - 2 && !(time < rotations[r + 1].timeStamp))
+				r++;
+			cursors[b].position = p;
+			cursors[b].rotation = r;
+			checksum += clip[b].Sample(time, cursors[b])[3][0];
+			linearUpdates++;
+		}
+	}
+	const double linearTime = elapsed(start) / linearUpdates;
+
+	// playback with cursors
+	cursors.assign(bones, BoneCursor());
+	start = Clock::now();
+	for (int frame = 0; frame < keys - 1; frame++)
+		for (int b = 0; b < bones; b++)
+			checksum += clip[b].Sample(frame + 0.5f, cursors[b])[3][0];
+	const double cursorTime = elapsed(start) / (double(keys - 1) * bones);
+
+	// random seeks fall back to binary search
+	std::mt19937 rng(42);
+	std::uniform_real_distribution<float> randomTime(0.0f, duration);
+	std::vector<float> seeks(4096);
+	for (float& time : seeks)
+		time = randomTime(rng);
+	start = Clock::now();
+	for (float time : seeks)
+		for (int b = 0; b < bones; b++)
+			checksum += clip[b].Sample(time, cursors[b])[3][0];
+	const double seekTime = elapsed(start) / (double(seeks.size()) * bones);
+
+	// resampled to one key per tick (the rate of the clip), every lookup is a multiplication
+	std::vector<Bone> resampled = clip;
+	for (Bone& bone : resampled)
+		bone.Resample(1.0f, duration);
+	start = Clock::now();
+	for (float time : seeks)
+		for (int b = 0; b < bones; b++)
+			checksum += resampled[b].Sample(time, cursors[b])[3][0];
+	const double resampledTime = elapsed(start) / (double(seeks.size()) * bones);
+
+	float maxError = 0.0f;
+	for (float time : seeks)
+	{
+		BoneCursor a, b;
+		const glm::mat4 difference = clip[0].Sample(time, a) - resampled[0].Sample(time, b);
+		for (int c = 0; c < 4; c++)
+			for (int r = 0; r < 4; r++)
+				maxError = std::max(maxError, std::abs(difference[c][r]));
+	}
+
+	printf("%d bones, %d keys per track (checksum %g)\n", bones, keys, checksum);
+	printf("linear scan from key 0:  %9.1f ns per bone update\n", linearTime);
+	printf("cursor, playing forward: %9.1f ns per bone update\n", cursorTime);
+	printf("cursor, random seeks:    %9.1f ns per bone update\n", seekTime);
+	printf("resampled, random seeks: %9.1f ns per bone update (max difference %g)\n", resampledTime, maxError);
+}
+
+// a skeleton of boneCount animated bones with keys keys per track (60 per second). Like imported rigs, every bone
+// sits below a static helper node that isn't a bone, and the bones branch into five chains from the hips. Clips with
+// another phase move differently on the same skeleton.
+// ----------------------------------------------------------------------------------------------------------------
+Animation makeSyntheticAnimation(int boneCount, int keys, float phase)
+{
+	std::vector<Bone> bones;
+	std::map<std::string, BoneInfo> boneInfoMap;
+	std::vector<AssimpNodeData> nodes(boneCount);
+	std::vector<int> parents(boneCount, -1);
+	for (int b = 0; b < boneCount; b++)
+	{
+		const std::string name = "bone" + std::to_string(b);
+		std::vector<KeyPosition> positions(keys);
+		std::vector<KeyRotation> rotations(keys);
+		for (int k = 0; k < keys; k++)
+		{
+			positions[k] = { glm::vec3(0.0f, 0.1f + 0.01f * std::sin(k * 0.05f + b + phase), 0.0f), (float)k };
+			rotations[k] = { glm::angleAxis(0.3f * std::sin(k * 0.02f + b + phase), glm::normalize(glm::vec3(1.0f, b % 3, 0.5f))), (float)k };
+		}
+		bones.emplace_back(name, b, positions, rotations, std::vector<KeyScale>{ { glm::vec3(1.0f), 0.0f } });
+		boneInfoMap[name] = BoneInfo{ b, glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, -0.1f * b, 0.0f)) };
+
+		nodes[b].name = name;
+		nodes[b].transformation = glm::mat4(1.0f);
+		nodes[b].childrenCount = 0;
+		parents[b] = b == 0 ? -1 : b <= 5 ? 0 : b - 5;
+	}
+
+	// assemble the tree bottom up, wrapping every bone in a helper node
+	for (int b = boneCount - 1; b >= 0; b--)
+	{
+		AssimpNodeData helper;
+		helper.name = nodes[b].name + "_helper";
+		helper.transformation = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.1f, 0.0f));
+		helper.childrenCount = 1;
+		helper.children.push_back(std::move(nodes[b]));
+		if (parents[b] < 0)
+			nodes[b] = std::move(helper);
+		else
+		{
+			nodes[parents[b]].children.insert(nodes[parents[b]].children.begin(), std::move(helper));
+			nodes[parents[b]].childrenCount++;
+		}
+	}
+	return Animation(float(keys - 1), 60, nodes[0], std::move(bones), boneInfoMap);
+}
+
+// per-frame cost of Animator::CalculateBoneTransform (the recursive evaluation) and Animator::UpdateAnimation
+// -----------------------------------------------------------------------------------------------------------
+void animatorBenchmark(int boneCount, int frames)
+{
+	typedef std::chrono::steady_clock Clock;
+	auto elapsed = [](Clock::time_point start) { return std::chrono::duration<double, std::micro>(Clock::now() - start).count(); };
+
+	// both evaluate the pose at the same clip time over and over
+	Animation animation = makeSyntheticAnimation(boneCount, 600);
+	Animator recursive(&animation), compiled(&animation);
+	recursive.UpdateAnimation(3.3f);
+	compiled.UpdateAnimation(3.3f);
+
+	auto start = Clock::now();
+	for (int frame = 0; frame < frames; frame++)
+		recursive.CalculateBoneTransform(&animation.GetRootNode(), glm::mat4(1.0f));
+	const double recursiveTime = elapsed(start) / frames;
+
+	start = Clock::now();
+	for (int frame = 0; frame < frames; frame++)
+		compiled.UpdateAnimation(0.0f);
+	const double compiledTime = elapsed(start) / frames;
+
+	const std::vector<glm::mat4> a = recursive.GetFinalBoneMatrices(), b = compiled.GetFinalBoneMatrices();
+	float maxError = 0.0f;
+	for (int i = 0; i < boneCount; i++)
+		for (int c = 0; c < 4; c++)
+			for (int r = 0; r < 4; r++)
+				maxError = std::max(maxError, std::abs(a[i][c][r] - b[i][c][r]));
+
+	printf("%d bones, %zu nodes, %d frames\n", boneCount, animation.GetNodes().size(), frames);
+	printf("recursive, by name:  %8.2f us per update\n", recursiveTime);
+	printf("compiled hierarchy:  %8.2f us per update\n", compiledTime);
+	printf("max difference: %g\n", maxError);
+}
+
+// characters animated per millisecond by AnimationSystem::Update, with 1, 2, 4, ... threads up to every hardware
+// thread. Every character plays the same 60 bone clip from a different start time.
+// ---------------------------------------------------------------------------------------------------------------
+void crowdBenchmark(int characters, int frames)
+{
+	typedef std::chrono::steady_clock Clock;
+	const int boneCount = 60;
+	const float dt = 1.0f / 60.0f;
+	Animation animation = makeSyntheticAnimation(boneCount, 600);
+
+	std::vector<unsigned int> threadCounts;
+	const unsigned int cores = std::max(std::thread::hardware_concurrency(), 1u);
+	for (unsigned int threads = 1; threads < cores; threads *= 2)
+		threadCounts.push_back(threads);
+	threadCounts.push_back(cores);
+
+	printf("%d characters, %d bones, %zu nodes, %d frames, %u hardware threads\n", characters, boneCount, animation.GetNodes().size(), frames, cores);
+	std::vector<glm::mat4> reference;
+	double singleThreaded = 0.0;
+	for (unsigned int threads : threadCounts)
+	{
+		ThreadPool pool(threads - 1); // the calling thread works too
+		AnimationSystem system(boneCount, &pool);
+		for (int i = 0; i < characters; i++)
+			system.AddInstance(&animation, 0.37f * i);
+		system.Update(dt);
+
+		const auto start = Clock::now();
+		for (int frame = 0; frame < frames; frame++)
+			system.Update(dt);
+		const double ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count() / frames;
+		if (reference.empty())
+		{
+			reference = system.GetPalettes();
+			singleThreaded = ms;
+		}
+
+		// every thread count has to produce exactly the single threaded palettes
+		float maxError = 0.0f;
+		for (size_t i = 0; i < reference.size(); i++)
+			for (int c = 0; c < 4; c++)
+				for (int r = 0; r < 4; r++)
+					maxError = std::max(maxError, std::abs(reference[i][c][r] - system.GetPalettes()[i][c][r]));
+		printf("%2u threads: %8.3f ms per frame, %8.1f characters/ms, %5.2fx (max difference %g)\n",
+			threads, ms, characters / ms, singleThreaded / ms, maxError);
+	}
+
+	// the first character starts at time 0, like a lone Animator
+	Animator animator(&animation);
+	for (int frame = 0; frame < frames + 1; frame++)
+		animator.UpdateAnimation(dt);
+	const std::vector<glm::mat4> single = animator.GetFinalBoneMatrices();
+	float maxError = 0.0f;
+	for (int b = 0; b < boneCount; b++)
+		for (int c = 0; c < 4; c++)
+			for (int r = 0; r < 4; r++)
+				maxError = std::max(maxError, std::abs(reference[b][c][r] - single[b][c][r]));
+	printf("first character vs Animator: max difference %g\n", maxError);
+}
+
+// key memory of a clip before and after Animation::Compress, the worst difference of any bone in model space over
+// the whole clip (sampled every half tick), and the cost of a bone update playing forward
+// ---------------------------------------------------------------------------------------------------------------
+void compressionReport(const char* name, const Animation& clip, const BoneCompression& settings)
+{
+	typedef std::chrono::steady_clock Clock;
+	Animation compressed = clip;
+	auto start = Clock::now();
+	compressed.Compress(settings);
+	const double compressTime = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+	size_t keys = 0, keptKeys = 0, constantTracks = 0;
+	for (size_t b = 0; b < clip.GetBones().size(); b++)
+	{
+		const Bone& original = clip.GetBones()[b];
+		const Bone& reduced = compressed.GetBones()[b];
+		keys += original.GetPositionKeys().size() + original.GetRotationKeys().size() + original.GetScaleKeys().size();
+		for (const CompressedTrack* track : { &reduced.GetCompressedPositions(), &reduced.GetCompressedRotations(), &reduced.GetCompressedScales() })
+		{
+			keptKeys += track->GetKeyCount();
+			constantTracks += track->GetKeyCount() == 1;
+		}
+	}
+
+	// both clips posed at the same times, every node compared in model space
+	const size_t nodeCount = clip.GetNodes().size();
+	std::vector<BoneCursor> cursorsA(clip.GetBones().size()), cursorsB(clip.GetBones().size());
+	std::vector<glm::mat4> globalsA(nodeCount), globalsB(nodeCount), palette(std::max(clip.GetPaletteSize(), 1));
+	float positionError = 0.0f, rotationError = 0.0f;
+	for (float time = 0.0f; time <= clip.GetDuration(); time += 0.5f)
+	{
+		clip.Evaluate(time, cursorsA.data(), globalsA.data(), palette.data(), 0);
+		compressed.Evaluate(time, cursorsB.data(), globalsB.data(), palette.data(), 0);
+		for (size_t i = 0; i < nodeCount; i++)
+		{
+			positionError = std::max(positionError, glm::length(glm::vec3(globalsA[i][3]) - glm::vec3(globalsB[i][3])));
+			const glm::quat a = glm::quat_cast(glm::mat3(glm::normalize(glm::vec3(globalsA[i][0])), glm::normalize(glm::vec3(globalsA[i][1])), glm::normalize(glm::vec3(globalsA[i][2]))));
+			const glm::quat b = glm::quat_cast(glm::mat3(glm::normalize(glm::vec3(globalsB[i][0])), glm::normalize(glm::vec3(globalsB[i][1])), glm::normalize(glm::vec3(globalsB[i][2]))));
+			rotationError = std::max(rotationError, Bone::AngleBetween(a, b));
+		}
+	}
+
+	// playing forward, one bone update per bone and frame
+	auto updateTime = [](const Animation& animation)
+	{
+		const std::vector<Bone>& bones = animation.GetBones();
+		std::vector<BoneCursor> cursors(bones.size());
+		float checksum = 0.0f;
+		size_t updates = 0;
+		const auto start = Clock::now();
+		for (float time = 0.0f; time < animation.GetDuration(); time += 0.5f)
+			for (size_t b = 0; b < bones.size(); b++, updates++)
+				checksum += bones[b].Sample(time, cursors[b])[3][0];
+		const double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+		return updates && checksum == checksum ? ns / updates : 0.0;
+	};
+
+	const size_t before = clip.GetKeyMemory(), after = compressed.GetKeyMemory();
+	printf("%s: %zu bones, %.0f ticks, compressed in %.1f ms\n", name, clip.GetBones().size(), clip.GetDuration(), compressTime);
+	printf("keys:   %9zu -> %9zu (%zu of %zu tracks constant)\n", keys, keptKeys, constantTracks, clip.GetBones().size() * 3);
+	printf("memory: %9zu -> %9zu bytes (%.1fx smaller)\n", before, after, after ? double(before) / after : 0.0);
+	printf("worst bone error: %g units, %g degrees\n", positionError, glm::degrees(rotationError));
+	printf("bone update: %.1f ns -> %.1f ns\n", updateTime(clip), updateTime(compressed));
+}
+
+// per-frame cost of Animator::UpdateAnimation with one clip, halfway through a crossfade between two clips and
+// with an additive layer on top of the crossfade
+// ---------------------------------------------------------------------------------------------------------------
+void blendBenchmark(int boneCount, int frames)
+{
+	typedef std::chrono::steady_clock Clock;
+	const float dt = 1.0f / 60.0f;
+	Animation walk = makeSyntheticAnimation(boneCount, 600), run = makeSyntheticAnimation(boneCount, 600, 1.5f);
+	Animation breathe = makeSyntheticAnimation(boneCount, 600, 3.0f);
+
+	auto updateTime = [&](Animator& animator)
+	{
+		animator.UpdateAnimation(dt);
+		const auto start = Clock::now();
+		for (int frame = 0; frame < frames; frame++)
+			animator.UpdateAnimation(dt);
+		return std::chrono::duration<double, std::micro>(Clock::now() - start).count() / frames;
+	};
+
+	Animator single(&walk);
+	const double singleTime = updateTime(single);
+
+	Animator crossfade(&walk);
+	crossfade.CrossFade(&run, 1e6f); // stays halfway through the fade for the whole run
+	const double crossfadeTime = updateTime(crossfade);
+
+	Animator layered(&walk);
+	layered.CrossFade(&run, 1e6f);
+	layered.AddLayer(&breathe, 0.5f);
+	const double layeredTime = updateTime(layered);
+
+	// blending in pose space has to reproduce the matrix path: a clip faded into itself (both copies start at 0)
+	// is the clip
+	Animator reference(&walk), blended(&walk);
+	blended.CrossFade(&walk, 1e6f);
+	float maxError = 0.0f;
+	for (int frame = 0; frame < 100; frame++)
+	{
+		reference.UpdateAnimation(dt);
+		blended.UpdateAnimation(dt);
+		const std::vector<glm::mat4>& a = reference.GetFinalBoneMatrices();
+		const std::vector<glm::mat4>& b = blended.GetFinalBoneMatrices();
+		for (int i = 0; i < boneCount; i++)
+			for (int c = 0; c < 4; c++)
+				for (int r = 0; r < 4; r++)
+					maxError = std::max(maxError, std::abs(a[i][c][r] - b[i][c][r]));
+	}
+
+	printf("%d bones, %zu nodes, %d frames\n", boneCount, walk.GetNodes().size(), frames);
+	printf("one clip:              %8.2f us per update\n", singleTime);
+	printf("crossfade, two clips:  %8.2f us per update (%.2fx)\n", crossfadeTime, crossfadeTime / singleTime);
+	printf("crossfade + additive:  %8.2f us per update (%.2fx)\n", layeredTime, layeredTime / singleTime);
+	printf("clip crossfaded into itself vs the clip alone: max difference %g\n", maxError);
+}
+
+// vertices skinned per second by CpuSkinning on a synthetic mesh posed by a 100 bone Animator: the scalar reference,
+// the SIMD kernel on the calling thread and spread over the thread pool, each compared with the reference output
+// ---------------------------------------------------------------------------------------------------------------
+void skinningBenchmark(int vertexCount, int frames)
+{
+	typedef std::chrono::steady_clock Clock;
+	const int boneCount = 100;
+	Animation animation = makeSyntheticAnimation(boneCount, 600);
+	Animator animator(&animation);
+	animator.UpdateAnimation(1.3f);
+	const std::vector<glm::mat4>& palette = animator.GetFinalBoneMatrices();
+
+	// one to four influences with weights adding up to one, a few vertices without bones or past the palette
+	std::mt19937 rng(7);
+	std::uniform_real_distribution<float> unit(-1.0f, 1.0f), share(0.05f, 1.0f);
+	std::uniform_int_distribution<int> bone(0, boneCount - 1), influences(1, MAX_BONE_INFLUENCE);
+	std::vector<Vertex> vertices(vertexCount);
+	for (int v = 0; v < vertexCount; v++)
+	{
+		Vertex& vertex = vertices[v];
+		vertex.Position = glm::vec3(unit(rng), unit(rng) + 1.0f, unit(rng));
+		vertex.Normal = glm::normalize(glm::vec3(unit(rng), unit(rng), unit(rng)) + glm::vec3(0.0f, 0.0f, 2.0f));
+		const int used = v % 1000 == 0 ? 0 : influences(rng);
+		float total = 0.0f;
+		for (int i = 0; i < MAX_BONE_INFLUENCE; i++)
+		{
+			vertex.m_BoneIDs[i] = i < used ? bone(rng) : -1;
+			vertex.m_Weights[i] = i < used ? share(rng) : 0.0f;
+			total += vertex.m_Weights[i];
+		}
+		for (int i = 0; i < used; i++)
+			vertex.m_Weights[i] /= total;
+		if (v % 1000 == 1)
+			vertex.m_BoneIDs[0] = boneCount + 5;
+	}
+
+	std::vector<glm::vec3> referencePositions(vertexCount), referenceNormals(vertexCount);
+	std::vector<glm::vec3> positions(vertexCount), normals(vertexCount);
+	auto verticesPerSecond = [&](auto skin)
+	{
+		skin();
+		const auto start = Clock::now();
+		for (int frame = 0; frame < frames; frame++)
+			skin();
+		return double(vertexCount) * frames / std::chrono::duration<double>(Clock::now() - start).count();
+	};
+	auto maxDifference = [&]()
+	{
+		float difference = 0.0f;
+		for (int v = 0; v < vertexCount; v++)
+			for (int c = 0; c < 3; c++)
+			{
+				difference = std::max(difference, std::abs(positions[v][c] - referencePositions[v][c]));
+				difference = std::max(difference, std::abs(normals[v][c] - referenceNormals[v][c]));
+			}
+		return difference;
+	};
+
+	const double reference = verticesPerSecond([&] {
+		CpuSkinning::SkinReference(vertices.data(), vertices.size(), palette.data(), (int)palette.size(), referencePositions.data(), referenceNormals.data()); });
+	const double kernel = verticesPerSecond([&] {
+		CpuSkinning::SkinRange(vertices.data(), vertices.size(), palette.data(), (int)palette.size(), positions.data(), normals.data()); });
+	const float kernelDifference = maxDifference();
+	std::fill(positions.begin(), positions.end(), glm::vec3(0.0f));
+	const double threaded = verticesPerSecond([&] { CpuSkinning::Skin(vertices, palette, positions, normals); });
+	const float threadedDifference = maxDifference();
+
+#if defined(CPU_SKINNING_AVX)
+	const char* isa = "AVX";
+#elif defined(CPU_SKINNING_SSE)
+	const char* isa = "SSE";
+#else
+	const char* isa = "scalar";
+#endif
+	printf("%d vertices, %d bones, %d frames, %s kernel\n", vertexCount, boneCount, frames, isa);
+	printf("scalar reference:        %8.1f M vertices/s\n", reference / 1e6);
+	printf("kernel, one thread:      %8.1f M vertices/s (%.2fx, max difference %g)\n", kernel / 1e6, kernel / reference, kernelDifference);
+	printf("kernel, %2u threads:      %8.1f M vertices/s (%.2fx, max difference %g)\n", ThreadPool::shared().size() + 1,
+		threaded / 1e6, threaded / reference, threadedDifference);
+}
@@ -10,6 +10,11 @@
 #include <learnopengl/camera.h>
 #include <learnopengl/model.h>
 #include <learnopengl/entity.h>
+#include <learnopengl/flat_scene.h>
+#include <learnopengl/frustum_cull.h>
+#include <learnopengl/aabb_tree.h>
+
+#include "planet_grid.h"
 
 #ifndef ENTITY_H
 #define ENTITY_H
@@ -26,6 +31,10 @@ public:
 #endif
 
 
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
 #include <iostream>
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
@@ -50,6 +59,7 @@ float lastFrame = 0.0f;
 
 int main()
 {
+
 	// glfw: initialize and configure
 	// ------------------------------
 	glfwInit();
@@ -102,27 +112,20 @@ int main()
 	// load entities
 	// -----------
 	Model model(FileSystem::getPath("resources/objects/planet/planet.obj"));
-	Entity ourEntity(model);
-	ourEntity.transform.setLocalPosition({ 0, 0, 0 });
-	const float scale = 1.0;
-	ourEntity.transform.setLocalScale({ scale, scale, scale });
-
-	{
-		Entity* lastEntity = &ourEntity;
-
-		for (unsigned int x = 0; x < 20; ++x)
-		{
-			for (unsigned int z = 0; z < 20; ++z)
-			{
-				ourEntity.addChild(model);
-				lastEntity = ourEntity.children.back().get();
-
-				//Set transform values
-				lastEntity->transform.setLocalPosition({ x * 10.f - 100.f,  0.f, z * 10.f - 100.f });
-			}
-		}
-	}
-	ourEntity.updateSelfAndChild();
+	const AABB modelBounds = generateAABB(model);
+
+	// entities=N puts N planets on the grid instead of 400, e.g. entities=1000000
+	const char* entities = getenv("entities");
+	FlatScene scene;
+	const FlatScene::Node root = buildPlanetGrid(scene, entities ? std::max(atoi(entities), 1) : 400);
+	scene.update();
+	AABBArray worldBounds;
+	updateWorldBounds(scene, root, modelBounds, worldBounds);
+	AABBTree tree;
+	tree.build(worldBounds);
+	std::vector<uint32_t> visible;
+	double updateTime = 0.0, cullTime = 0.0;
+	float lastReport = 0.0f;
 
 	// draw in wireframe
 	//glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
@@ -162,13 +165,34 @@ int main()
 		ourShader.setMat4("projection", projection);
 		ourShader.setMat4("view", view);
 
-		// draw our scene graph
-		unsigned int total = 0, display = 0;
-		ourEntity.drawSelfAndChild(camFrustum, ourShader, display, total);
-		std::cout << "Total process in CPU : " << total << " / Total send to GPU : " << display << std::endl;
+		// walk the bounding volume hierarchy for the visible planets, then draw them
+		const auto cullStart = std::chrono::steady_clock::now();
+		visible.clear();
+		tree.query(camFrustum, visible);
+		cullTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - cullStart).count();
+		const size_t display = visible.size();
+		for (uint32_t i : visible)
+		{
+			ourShader.setMat4("model", scene.getModelMatrix(root + i));
+			model.Draw(ourShader);
+		}
 
-		//ourEntity.transform.setLocalRotation({ 0.f, ourEntity.transform.getLocalRotation().y + 20 * deltaTime, 0.f });
-		ourEntity.updateSelfAndChild();
+		// report once a second rather than every frame
+		if (currentFrame - lastReport >= 1.0f)
+		{
+			std::cout << "Total process in CPU : " << worldBounds.size() << " / Total send to GPU : " << display
+				<< " / Scene update : " << updateTime << " ms / Culling : " << cullTime << " ms" << std::endl;
+			lastReport = currentFrame;
+		}
+
+		//scene.setLocalRotation(root, { 0.f, scene.getLocalRotation(root).y + 20 * deltaTime, 0.f });
+		const auto updateStart = std::chrono::steady_clock::now();
+		if (scene.update())
+		{
+			updateWorldBounds(scene, root, modelBounds, worldBounds);
+			tree.refit();
+		}
+		updateTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - updateStart).count();
 
 		// glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
 		// -------------------------------------------------------------------------------
@@ -0,0 +1,43 @@
+#ifndef PLANET_GRID_H
+#define PLANET_GRID_H
+
+#include <learnopengl/flat_scene.h>
+#include <learnopengl/frustum_cull.h>
+
+#include <cmath>
+
+// the planet field of the frustum culling demo, shared with frustum_culling_bench
+
+// one root planet with count - 1 children on a square grid, 10 units apart
+// -----------------------------------------------------------------------
+inline FlatScene::Node buildPlanetGrid(FlatScene& scene, unsigned int count)
+{
+	scene.reserve(count);
+	const FlatScene::Node root = scene.add();
+	const unsigned int side = (unsigned int)std::ceil(std::sqrt((double)count - 1));
+	for (unsigned int i = 0; i + 1 < count; ++i)
+	{
+		const FlatScene::Node node = scene.add(root);
+		scene.setLocalPosition(node, { (i / side) * 10.f - side * 5.f, 0.f, (i % side) * 10.f - side * 5.f });
+	}
+	return root;
+}
+
+// world space AABB of every node from first on, all sharing the model space box local
+// ------------------------------------------------------------------------------------
+inline void updateWorldBounds(const FlatScene& scene, FlatScene::Node first, const AABB& local, AABBArray& bounds)
+{
+	bounds.resize(scene.size() - first);
+	for (size_t i = 0; i < bounds.size(); i++)
+	{
+		const FlatScene::Affine& w = scene.getWorldAffine(first + FlatScene::Node(i));
+		glm::vec3 center, extents;
+		for (int r = 0; r < 3; r++)
+		{
+			center[r] = w.m[r][0] * local.center.x + w.m[r][1] * local.center.y + w.m[r][2] * local.center.z + w.m[r][3];
+			extents[r] = std::abs(w.m[r][0]) * local.extents.x + std::abs(w.m[r][1]) * local.extents.y + std::abs(w.m[r][2]) * local.extents.z;
+		}
+		bounds.set(i, center, extents);
+	}
+}
+#endif
@@ -0,0 +1,251 @@
+#include <glm/glm.hpp>
+
+#include <learnopengl/camera.h>
+#include <learnopengl/model.h>
+#include <learnopengl/entity.h>
+#include <learnopengl/flat_scene.h>
+#include <learnopengl/frustum_cull.h>
+#include <learnopengl/aabb_tree.h>
+
+#include "../2.frustum_culling/planet_grid.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <list>
+#include <memory>
+#include <random>
+
+// CPU only benchmarks of the frustum culling demo's scene and culling code; no window or GL context is created.
+// Pick one with an environment variable, e.g. cull_bench=100000 (see the *.bench tasks in the Runfile).
+
+void sceneBenchmark(unsigned int count, unsigned int frames);
+void cullBenchmark(unsigned int count, unsigned int frames);
+
+// settings
+const unsigned int SCR_WIDTH = 800;
+const unsigned int SCR_HEIGHT = 600;
+
+// the demo's starting camera
+Camera camera(glm::vec3(0.0f, 10.0f, 0.0f));
+
+int main()
+{
+	// cost of the transform update, FlatScene vs the Entity tree, e.g. scene_bench=1000000
+	if (const char* bench = getenv("scene_bench"))
+	{
+		sceneBenchmark(std::max(atoi(bench), 1), 20);
+		return 0;
+	}
+	// boxes culled per second, AABB::isOnFrustum vs cullAABBs vs AABBTree, e.g. cull_bench=100000
+	if (const char* bench = getenv("cull_bench"))
+	{
+		cullBenchmark(std::max(atoi(bench), 1), 20);
+		return 0;
+	}
+	printf("set scene_bench or cull_bench\n");
+	return 1;
+}
+
+// times the per-frame transform update of count entities, with the same hierarchy stored as a FlatScene and as an
+// Entity style tree (std::list of children, recursive update); the tree node only drops the Model from Entity
+// ---------------------------------------------------------------------------------------------------------------
+struct TreeNode
+{
+	std::list<std::unique_ptr<TreeNode>> children;
+	TreeNode* parent = nullptr;
+	Transform transform;
+
+	void updateSelfAndChild()
+	{
+		if (transform.isDirty())
+		{
+			forceUpdateSelfAndChild();
+			return;
+		}
+		for (auto&& child : children)
+			child->updateSelfAndChild();
+	}
+
+	void forceUpdateSelfAndChild()
+	{
+		if (parent)
+			transform.computeModelMatrix(parent->transform.getModelMatrix());
+		else
+			transform.computeModelMatrix();
+		for (auto&& child : children)
+			child->forceUpdateSelfAndChild();
+	}
+};
+
+void sceneBenchmark(unsigned int count, unsigned int frames)
+{
+	typedef std::chrono::steady_clock Clock;
+	auto elapsed = [](Clock::time_point start) { return std::chrono::duration<double, std::milli>(Clock::now() - start).count(); };
+
+	FlatScene scene;
+	const FlatScene::Node root = buildPlanetGrid(scene, count);
+	scene.update();
+
+	TreeNode tree;
+	for (FlatScene::Node node = root + 1; node < scene.size(); node++)
+	{
+		tree.children.emplace_back(std::make_unique<TreeNode>());
+		tree.children.back()->parent = &tree;
+		tree.children.back()->transform.setLocalPosition(scene.getLocalPosition(node));
+	}
+	tree.updateSelfAndChild();
+	std::vector<TreeNode*> treeNodes;
+	for (auto&& child : tree.children)
+		treeNodes.push_back(child.get());
+
+	// every frame the root turns, which moves everything
+	auto start = Clock::now();
+	for (unsigned int frame = 0; frame < frames; frame++)
+	{
+		tree.transform.setLocalRotation({ 0.f, frame * 0.5f, 0.f });
+		tree.updateSelfAndChild();
+	}
+	const double treeAll = elapsed(start) / frames;
+	start = Clock::now();
+	for (unsigned int frame = 0; frame < frames; frame++)
+	{
+		scene.setLocalRotation(root, { 0.f, frame * 0.5f, 0.f });
+		scene.update();
+	}
+	const double flatAll = elapsed(start) / frames;
+
+	// every frame 1% of the entities move
+	const size_t moving = std::max<size_t>(treeNodes.size() / 100, 1);
+	start = Clock::now();
+	for (unsigned int frame = 0; frame < frames; frame++)
+	{
+		for (size_t i = 0; i < moving && !treeNodes.empty(); i++)
+		{
+			Transform& transform = treeNodes[(i * 7919 + frame) % treeNodes.size()]->transform;
+			transform.setLocalPosition(transform.getLocalPosition() + glm::vec3(0.f, 0.01f, 0.f));
+		}
+		tree.updateSelfAndChild();
+	}
+	const double treeSome = elapsed(start) / frames;
+	start = Clock::now();
+	for (unsigned int frame = 0; frame < frames; frame++)
+	{
+		for (size_t i = 0; i < moving && !treeNodes.empty(); i++)
+		{
+			const FlatScene::Node node = root + 1 + FlatScene::Node((i * 7919 + frame) % treeNodes.size());
+			scene.setLocalPosition(node, scene.getLocalPosition(node) + glm::vec3(0.f, 0.01f, 0.f));
+		}
+		scene.update();
+	}
+	const double flatSome = elapsed(start) / frames;
+
+	// both must agree, and reading the results keeps the updates from being optimized away
+	float maxError = 0.f;
+	for (size_t i = 0; i < treeNodes.size(); i++)
+	{
+		const glm::vec3 difference = scene.getGlobalPosition(root + 1 + FlatScene::Node(i)) - glm::vec3(treeNodes[i]->transform.getModelMatrix()[3]);
+		maxError = std::max(maxError, std::max(std::max(std::abs(difference.x), std::abs(difference.y)), std::abs(difference.z)));
+	}
+
+	printf("%u entities, %u frames\n", count, frames);
+	printf("                  all moving      1%% moving\n");
+	printf("Entity tree:  %9.3f ms/frame %9.3f ms/frame\n", treeAll, treeSome);
+	printf("FlatScene:    %9.3f ms/frame %9.3f ms/frame\n", flatAll, flatSome);
+	printf("max position difference: %g\n", maxError);
+}
+
+// boxes per second through AABB::isOnFrustum (one box, six virtual plane tests), cullAABBs and an AABBTree query,
+// plus the cost of keeping the tree up to date when 1% of the boxes move
+// ---------------------------------------------------------------------------------------------------------------
+void cullBenchmark(unsigned int count, unsigned int frames)
+{
+	typedef std::chrono::steady_clock Clock;
+	auto elapsed = [](Clock::time_point start) { return std::chrono::duration<double>(Clock::now() - start).count(); };
+
+	std::mt19937 rng(42);
+	std::uniform_real_distribution<float> coordinate(-200.0f, 200.0f);
+	std::uniform_real_distribution<float> extent(0.5f, 2.0f);
+	std::vector<AABB> boxes;
+	AABBArray batch;
+	batch.resize(count);
+	for (unsigned int i = 0; i < count; i++)
+	{
+		boxes.emplace_back(glm::vec3(coordinate(rng), coordinate(rng), coordinate(rng)), extent(rng), extent(rng), extent(rng));
+		batch.set(i, boxes.back());
+	}
+	const Frustum frustum = createFrustumFromCamera(camera, (float)SCR_WIDTH / (float)SCR_HEIGHT, glm::radians(camera.Zoom), 0.1f, 100.0f);
+
+	size_t singleVisible = 0;
+	auto start = Clock::now();
+	for (unsigned int frame = 0; frame < frames; frame++)
+	{
+		singleVisible = 0;
+		for (const AABB& box : boxes)
+			singleVisible += box.isOnFrustum(frustum);
+	}
+	const double singleTime = elapsed(start);
+
+	std::vector<uint32_t> visible;
+	size_t batchVisible = 0;
+	start = Clock::now();
+	for (unsigned int frame = 0; frame < frames; frame++)
+		batchVisible = cullAABBs(frustum, batch, visible);
+	const double batchTime = elapsed(start);
+
+	start = Clock::now();
+	AABBTree tree;
+	tree.build(batch);
+	const double buildTime = elapsed(start);
+	std::vector<uint32_t> treeVisible;
+	size_t nodesTested = 0;
+	start = Clock::now();
+	for (unsigned int frame = 0; frame < frames; frame++)
+	{
+		treeVisible.clear();
+		nodesTested = tree.query(frustum, treeVisible);
+	}
+	const double treeTime = elapsed(start);
+
+	// the batch can only disagree with AABB::isOnFrustum on boxes touching a plane, where rounding differs
+	size_t mismatches = 0, treeMismatches = 0;
+	for (unsigned int i = 0; i < count; i++)
+		mismatches += boxes[i].isOnFrustum(frustum) != isVisible(visible, i);
+	std::vector<uint32_t> treeMask((count + 31) / 32, 0);
+	for (uint32_t i : treeVisible)
+		treeMask[i / 32] |= 1u << (i % 32);
+	for (size_t word = 0; word < treeMask.size(); word++)
+		treeMismatches += countBits(treeMask[word] ^ visible[word]);
+
+	// move 1% of the boxes a little, then bring the tree up to date
+	std::vector<uint32_t> moved;
+	for (unsigned int i = 0; i < count; i += 100)
+	{
+		moved.push_back(i);
+		batch.centerY[i] += 1.0f;
+	}
+	start = Clock::now();
+	tree.refit(moved);
+	const double movedRefitTime = elapsed(start);
+	start = Clock::now();
+	tree.refit();
+	const double fullRefitTime = elapsed(start);
+
+#if defined(FRUSTUM_CULL_AVX)
+	const char* path = "AVX, 8 boxes";
+#elif defined(FRUSTUM_CULL_SSE)
+	const char* path = "SSE, 4 boxes";
+#else
+	const char* path = "scalar";
+#endif
+	printf("%u boxes, %u frames, %zu visible\n", count, frames, batchVisible);
+	printf("AABB::isOnFrustum:        %8.1f M boxes/s\n", count * double(frames) / singleTime * 1e-6);
+	printf("cullAABBs (%s): %8.1f M boxes/s\n", path, count * double(frames) / batchTime * 1e-6);
+	printf("AABBTree::query:          %8.1f M boxes/s (%zu nodes tested, built in %.1f ms)\n",
+		count * double(frames) / treeTime * 1e-6, nodesTested, buildTime * 1e3);
+	printf("results differ for %zu boxes (%zu visible with AABB::isOnFrustum), tree vs batch for %zu boxes\n",
+		mismatches, singleVisible, treeMismatches);
+	printf("%zu boxes moved: refit moved %.3f ms, refit all %.3f ms, rebuild %.3f ms\n",
+		moved.size(), movedRefitTime * 1e3, fullRefitTime * 1e3, buildTime * 1e3);
+}